@@ -1,10 +1,123 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <cstddef>
+#include <cstdlib>
 #include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
 #include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <mcga/threading/base/latency_histogram.hpp>
+#include <mcga/threading/base/sp_immediate_queue_wrapper.hpp>
+
+#ifdef LINK_EVPP
+#include <evpp/event_loop.h>
+#include <evpp/event_loop_thread.h>
+#include <evpp/event_loop_thread_pool.h>
+#endif
+
+#ifdef MCGA_BENCHMARK_COUNT_ALLOCATIONS
+// Counts every heap allocation of the benchmark, plain, array and aligned.
+// Replacing the global operator new is only done by the benchmarks that
+// define MCGA_BENCHMARK_COUNT_ALLOCATIONS before including this file, since
+// it costs an atomic increment per allocation.
+std::atomic_size_t numAllocations = 0;
+
+namespace mcga::threading::benchmarks {
+
+inline void* countedAllocate(std::size_t size, std::size_t alignment) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    size = std::max(size, std::size_t{1});
+    void* ptr = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        ptr = std::malloc(size);
+    } else {
+        // aligned_alloc() wants a size that is a multiple of the alignment.
+        size = (size + alignment - 1) / alignment * alignment;
+        ptr = std::aligned_alloc(alignment, size);
+    }
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+}  // namespace mcga::threading::benchmarks
+
+// None of these are inlined into the callers, where GCC would see malloc()
+// paired with operator delete, or operator new with free(), and warn with
+// -Wmismatched-new-delete.
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    return mcga::threading::benchmarks::countedAllocate(
+      size, alignof(std::max_align_t));
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t size) {
+    return mcga::threading::benchmarks::countedAllocate(
+      size, alignof(std::max_align_t));
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size,
+                                     std::align_val_t alignment) {
+    return mcga::threading::benchmarks::countedAllocate(
+      size, static_cast<std::size_t>(alignment));
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t size,
+                                       std::align_val_t alignment) {
+    return mcga::threading::benchmarks::countedAllocate(
+      size, static_cast<std::size_t>(alignment));
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr,
+                                         std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr,
+                                       std::size_t,
+                                       std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete[](void* ptr,
+                                         std::size_t,
+                                         std::align_val_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
 inline std::ostream& operator<<(std::ostream& os,
                                 const std::chrono::nanoseconds& ns) {
     if (ns.count() > 1000000000) {
@@ -19,36 +132,50 @@ inline std::ostream& operator<<(std::ostream& os,
     return os;
 }
 
+// Percentiles come from a LatencyHistogram, so they are rounded up by at most
+// 1/16 of their value, and memory does not grow with the number of samples.
+// min() and max() are exact. Negative samples count as 0 in percentiles.
 class DurationTracker {
   public:
-    std::vector<std::chrono::nanoseconds> samples;
-
     void addSample(const std::chrono::nanoseconds& ns) {
-        samples.push_back(ns);
+        minSample = (count() == 0 ? ns : std::min(minSample, ns));
+        maxSample = (count() == 0 ? ns : std::max(maxSample, ns));
+        histogram.record(static_cast<std::uint64_t>(
+          std::max(ns.count(), decltype(ns.count()){0})));
     }
 
-    void organize() {
-        sort(samples.begin(), samples.end());
+    std::uint64_t count() const {
+        return histogram.count();
     }
 
     std::chrono::nanoseconds min() const {
-        return samples.front();
+        return minSample;
     }
 
     std::chrono::nanoseconds max() const {
-        return samples.back();
+        return maxSample;
     }
 
     std::chrono::nanoseconds percent(double p) const {
-        auto index = static_cast<size_t>(p * 0.01 * samples.size());
-        if (index >= samples.size() - 1) {
-            return max();
-        }
-        if (index < 1) {
-            return min();
+        return histogram.percentile(p);
+    }
+
+    DurationTracker& operator+=(const DurationTracker& other) {
+        if (other.count() == 0) {
+            return *this;
         }
-        return samples[index + 1];
+        minSample = (count() == 0 ? other.minSample
+                                  : std::min(minSample, other.minSample));
+        maxSample = (count() == 0 ? other.maxSample
+                                  : std::max(maxSample, other.maxSample));
+        histogram += other.histogram;
+        return *this;
     }
+
+  private:
+    mcga::threading::base::LatencyHistogram histogram;
+    std::chrono::nanoseconds minSample{0};
+    std::chrono::nanoseconds maxSample{0};
 };
 
 class Stopwatch {
@@ -69,3 +196,415 @@ class Stopwatch {
   private:
     std::chrono::steady_clock::time_point startTime;
 };
+
+// Uniform start / stop / enqueue over our constructs and, when benchmarking
+// against it, evpp's.
+
+template<class Loop>
+void startLoop(Loop& loop) {
+#ifdef LINK_EVPP
+    if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Loop>
+                  || std::is_same_v<evpp::EventLoopThread, Loop>) {
+        loop.Start(true);
+        return;
+    }
+#endif
+    loop.start();
+}
+
+template<class Loop>
+void stopLoop(Loop& loop) {
+#ifdef LINK_EVPP
+    if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Loop>
+                  || std::is_same_v<evpp::EventLoopThread, Loop>) {
+        loop.Stop(true);
+        return;
+    }
+#endif
+    loop.stop();
+}
+
+template<class Loop, class Task>
+void enqueueTo(Loop& loop, Task&& task) {
+#ifdef LINK_EVPP
+    if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Loop>) {
+        loop.GetNextLoop()->QueueInLoop(std::forward<Task>(task));
+        return;
+    } else if constexpr (std::is_same_v<evpp::EventLoopThread, Loop>) {
+        loop.loop()->QueueInLoop(std::forward<Task>(task));
+        return;
+    }
+#endif
+    loop.enqueue(std::forward<Task>(task));
+}
+
+// What one run of a benchmark measured: the total duration of the run, for
+// throughput, and whatever latency it samples (enqueue cost, timer error...).
+struct RunResult {
+    std::chrono::nanoseconds duration{0};
+    DurationTracker latencies;
+    std::optional<double> allocationsPerTask;
+};
+
+// One point of a scaling sweep. Single-thread constructs only run with
+// numThreads == 1.
+struct SweepPoint {
+    std::size_t numProducers = 1;
+    std::size_t numThreads = 1;
+    std::size_t taskSize = 0;
+};
+
+// The axes a benchmark is swept along. The ones left out stay at 1 producer,
+// 1 thread and a task size of 0, so e.g. a benchmark that enqueues from one
+// thread is not run once per --producers value.
+struct SweepAxes {
+    bool producers = false;
+    bool threads = false;
+    bool taskSizes = false;
+};
+
+template<class Loop>
+constexpr bool kIsPool = requires { typename Loop::NumThreads; }
+#ifdef LINK_EVPP
+  || std::is_same_v<evpp::EventLoopThreadPool, Loop>
+#endif
+  ;
+
+// Single-producer loops are not swept along the producer axis.
+template<class Loop>
+constexpr bool kIsSingleProducer = [] {
+    if constexpr (requires {
+                      typename Loop::Wrapped;
+                      typename Loop::Processor;
+                  }) {
+        return std::is_base_of_v<mcga::threading::base::SPImmediateQueueWrapper<
+                                   typename Loop::Processor>,
+                                 typename Loop::Wrapped>;
+    }
+    return false;
+}();
+
+// Builds a Loop for point: pools get point.numThreads threads, and args go
+// to the processor.
+template<class Loop, class... Args>
+std::unique_ptr<Loop> makeLoop(const SweepPoint& point, Args&... args) {
+#ifdef LINK_EVPP
+    if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Loop>) {
+        return std::make_unique<Loop>(nullptr, point.numThreads);
+    }
+#endif
+    if constexpr (requires { typename Loop::NumThreads; }) {
+        return std::make_unique<Loop>(
+          typename Loop::NumThreads(point.numThreads), args...);
+    } else {
+        return std::make_unique<Loop>(args...);
+    }
+}
+
+// Splits tasks [0, numTasks) between numProducers threads, each calling
+// enqueue(i) for its contiguous share. One enqueue() in every
+// kEnqueueSampleEvery is timed, and the returned tracker holds those
+// durations for all producers.
+template<class Enqueue>
+DurationTracker
+  produce(std::size_t numProducers, int numTasks, const Enqueue& enqueue) {
+    constexpr int kEnqueueSampleEvery = 64;
+
+    std::vector<DurationTracker> trackers(numProducers);
+    auto producer = [&](std::size_t p) {
+        const int first = static_cast<int>(numTasks * p / numProducers);
+        const int last = static_cast<int>(numTasks * (p + 1) / numProducers);
+        for (int i = first; i < last; ++i) {
+            if (i % kEnqueueSampleEvery == 0) {
+                Stopwatch watch;
+                enqueue(i);
+                trackers[p].addSample(watch.get());
+            } else {
+                enqueue(i);
+            }
+        }
+    };
+    if (numProducers == 1) {
+        producer(0);
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(numProducers);
+        for (std::size_t p = 0; p < numProducers; ++p) {
+            threads.emplace_back(producer, p);
+        }
+        for (std::thread& thread: threads) {
+            thread.join();
+        }
+    }
+    DurationTracker tracker;
+    for (const DurationTracker& producerTracker: trackers) {
+        tracker += producerTracker;
+    }
+    return tracker;
+}
+
+// Starts loop, enqueues tasks [0, numTasks) through enqueue(loop, i) from
+// point.numProducers threads, waits until isDone() and stops loop. The
+// duration covers enqueueing and executing all tasks, and the latencies are
+// those of the sampled enqueue() calls.
+template<class Loop, class Enqueue, class IsDone>
+RunResult runTasks(Loop& loop,
+                   int numTasks,
+                   const SweepPoint& point,
+                   const Enqueue& enqueue,
+                   const IsDone& isDone) {
+    startLoop(loop);
+    RunResult result;
+    Stopwatch watch;
+    result.latencies = produce(point.numProducers, numTasks, [&](int i) {
+        enqueue(loop, i);
+    });
+    while (!isDone()) {
+        std::this_thread::yield();
+    }
+    result.duration = watch.get();
+    stopLoop(loop);
+    return result;
+}
+
+// Runs the benchmarks and reports their results. Understands:
+//  --samples=N          tasks per run (a bare number works too)
+//  --repetitions=N      measured runs per benchmark and sweep point
+//  --warmup=N           unmeasured runs before those
+//  --producers=1,2,4    producer thread counts to sweep
+//  --threads=1,2,4,8    pool sizes to sweep
+//  --task-sizes=8,64    task sizes, in bytes, to sweep
+//  --format=text|json|csv
+// Throughput is reported as the median, min and max over the repetitions,
+// and latency percentiles over the samples of all repetitions.
+class BenchmarkHarness {
+  public:
+    enum class Format { kText, kJson, kCsv };
+
+    BenchmarkHarness(std::string name,
+                     int argc,
+                     char** argv,
+                     int defaultNumSamples,
+                     std::vector<std::size_t> defaultTaskSizes = {},
+                     std::vector<std::size_t> defaultProducerCounts = {1})
+            : name(std::move(name)), numSamples(defaultNumSamples),
+              producerCounts(std::move(defaultProducerCounts)),
+              taskSizes(std::move(defaultTaskSizes)) {
+        for (int i = 1; i < argc; ++i) {
+            parseArgument(argv[i]);
+        }
+    }
+
+    BenchmarkHarness(const BenchmarkHarness&) = delete;
+    BenchmarkHarness& operator=(const BenchmarkHarness&) = delete;
+
+    ~BenchmarkHarness() {
+        if (format == Format::kJson) {
+            printJson();
+        } else if (format == Format::kCsv) {
+            printCsv();
+        }
+    }
+
+    int getNumSamples() const {
+        return numSamples;
+    }
+
+    // Calls func(point) for every combination of the swept producer counts,
+    // pool sizes and task sizes, for the axes the benchmark sweeps.
+    template<class F>
+    void sweep(const SweepAxes& axes, const F& func) const {
+        const std::vector<std::size_t> one{1};
+        const std::vector<std::size_t> zero{0};
+        for (std::size_t numProducers: axes.producers ? producerCounts : one) {
+            for (std::size_t numThreads: axes.threads ? threadCounts : one) {
+                for (std::size_t taskSize: axes.taskSizes ? taskSizes : zero) {
+                    func(SweepPoint{numProducers, numThreads, taskSize});
+                }
+            }
+        }
+    }
+
+    // Starts a new section of the text output.
+    void section(const std::string& title) {
+        if (format == Format::kText) {
+            std::cout << "\n" << title << " (" << numSamples << " samples):\n";
+        }
+    }
+
+    // Calls run(numSamples) warmup + repetitions times, and records the
+    // result of the last repetitions runs.
+    template<class Run>
+    void measure(const std::string& variant,
+                 const SweepPoint& point,
+                 const Run& run) {
+        for (int i = 0; i < numWarmups; ++i) {
+            run(numSamples);
+        }
+        Result result{variant, point, {}, {}, std::nullopt};
+        for (int i = 0; i < numRepetitions; ++i) {
+            RunResult runResult = run(numSamples);
+            auto seconds
+              = std::chrono::duration<double>(runResult.duration).count();
+            result.throughputs.push_back(numSamples / seconds);
+            result.latencies += runResult.latencies;
+            result.allocationsPerTask = runResult.allocationsPerTask;
+        }
+        std::sort(result.throughputs.begin(), result.throughputs.end());
+        if (format == Format::kText) {
+            printText(result);
+        }
+        results.push_back(std::move(result));
+    }
+
+  private:
+    struct Result {
+        std::string variant;
+        SweepPoint point;
+        std::vector<double> throughputs;
+        DurationTracker latencies;
+        std::optional<double> allocationsPerTask;
+
+        double medianThroughput() const {
+            return throughputs[throughputs.size() / 2];
+        }
+    };
+
+    static std::vector<std::size_t> parseList(const std::string& list) {
+        std::vector<std::size_t> values;
+        std::stringstream stream(list);
+        std::string value;
+        while (std::getline(stream, value, ',')) {
+            values.push_back(std::stoul(value));
+        }
+        return values;
+    }
+
+    void parseArgument(const std::string& argument) {
+        auto value = argument.substr(argument.find('=') + 1);
+        if (argument.rfind("--samples=", 0) == 0) {
+            numSamples = std::stoi(value);
+        } else if (argument.rfind("--repetitions=", 0) == 0) {
+            numRepetitions = std::max(1, std::stoi(value));
+        } else if (argument.rfind("--warmup=", 0) == 0) {
+            numWarmups = std::stoi(value);
+        } else if (argument.rfind("--producers=", 0) == 0) {
+            producerCounts = parseList(value);
+        } else if (argument.rfind("--threads=", 0) == 0) {
+            threadCounts = parseList(value);
+        } else if (argument.rfind("--task-sizes=", 0) == 0) {
+            taskSizes = parseList(value);
+        } else if (argument == "--format=json") {
+            format = Format::kJson;
+        } else if (argument == "--format=csv") {
+            format = Format::kCsv;
+        } else if (argument == "--format=text") {
+            format = Format::kText;
+        } else if (!argument.empty() && std::isdigit(argument[0]) != 0) {
+            numSamples = std::stoi(argument);
+        } else {
+            std::cerr << "Unknown argument: " << argument << "\n";
+            std::exit(1);
+        }
+    }
+
+    void printText(const Result& result) const {
+        std::cout << "\t" << std::left << std::setw(38) << result.variant
+                  << std::right;
+        if (producerCounts.size() > 1 || result.point.numProducers > 1) {
+            std::cout << " producers=" << result.point.numProducers;
+        }
+        if (threadCounts.size() > 1 || result.point.numThreads > 1) {
+            std::cout << " threads=" << result.point.numThreads;
+        }
+        if (result.point.taskSize > 0) {
+            std::cout << " task=" << result.point.taskSize << "B";
+        }
+        std::cout << " " << std::fixed << std::setprecision(0)
+                  << result.medianThroughput() << " tasks/s";
+        if (result.latencies.count() > 0) {
+            std::cout << ", p50 " << result.latencies.percent(50) << ", p99 "
+                      << result.latencies.percent(99) << ", max "
+                      << result.latencies.max();
+        }
+        if (result.allocationsPerTask.has_value()) {
+            std::cout << ", " << std::fixed << std::setprecision(3)
+                      << *result.allocationsPerTask << " allocations / task";
+        }
+        std::cout << "\n";
+    }
+
+    void printJson() const {
+        std::cout << "[\n";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            std::cout << "  {\"benchmark\": \"" << name << "\", \"variant\": \""
+                      << result.variant << "\", \"producers\": "
+                      << result.point.numProducers
+                      << ", \"threads\": " << result.point.numThreads
+                      << ", \"task_size\": " << result.point.taskSize
+                      << ", \"tasks\": " << numSamples
+                      << ", \"repetitions\": " << numRepetitions
+                      << std::setprecision(1) << std::fixed
+                      << ", \"throughput_median\": "
+                      << result.medianThroughput()
+                      << ", \"throughput_min\": " << result.throughputs.front()
+                      << ", \"throughput_max\": " << result.throughputs.back()
+                      << ", \"latency_samples\": " << result.latencies.count()
+                      << ", \"latency_p50_ns\": "
+                      << result.latencies.percent(50).count()
+                      << ", \"latency_p99_ns\": "
+                      << result.latencies.percent(99).count()
+                      << ", \"latency_p999_ns\": "
+                      << result.latencies.percent(99.9).count()
+                      << ", \"latency_max_ns\": "
+                      << result.latencies.max().count()
+                      << ", \"allocations_per_task\": ";
+            if (result.allocationsPerTask.has_value()) {
+                std::cout << std::setprecision(3) << *result.allocationsPerTask;
+            } else {
+                std::cout << "null";
+            }
+            std::cout << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    }
+
+    void printCsv() const {
+        std::cout << "benchmark,variant,producers,threads,task_size,tasks,"
+                     "repetitions,throughput_median,throughput_min,"
+                     "throughput_max,latency_samples,latency_p50_ns,"
+                     "latency_p99_ns,latency_p999_ns,latency_max_ns,"
+                     "allocations_per_task\n";
+        for (const Result& result: results) {
+            std::cout << name << "," << result.variant << ","
+                      << result.point.numProducers << ","
+                      << result.point.numThreads << ","
+                      << result.point.taskSize << "," << numSamples << ","
+                      << numRepetitions << std::setprecision(1) << std::fixed
+                      << "," << result.medianThroughput() << ","
+                      << result.throughputs.front() << ","
+                      << result.throughputs.back() << ","
+                      << result.latencies.count() << ","
+                      << result.latencies.percent(50).count() << ","
+                      << result.latencies.percent(99).count() << ","
+                      << result.latencies.percent(99.9).count() << ","
+                      << result.latencies.max().count() << ",";
+            if (result.allocationsPerTask.has_value()) {
+                std::cout << std::setprecision(3) << *result.allocationsPerTask;
+            }
+            std::cout << "\n";
+        }
+    }
+
+    std::string name;
+    int numSamples;
+    int numRepetitions = 3;
+    int numWarmups = 1;
+    std::vector<std::size_t> producerCounts;
+    std::vector<std::size_t> threadCounts{
+      std::max(1U, std::thread::hardware_concurrency())};
+    std::vector<std::size_t> taskSizes;
+    Format format = Format::kText;
+    std::vector<Result> results;
+};
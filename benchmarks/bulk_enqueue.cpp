@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mcga/threading.hpp>
+
+#include "benchmark_utils.hpp"
+
+using mcga::threading::EventLoopThread;
+using mcga::threading::EventLoopThreadPool;
+using mcga::threading::SPEventLoopThread;
+using mcga::threading::SPEventLoopThreadPool;
+
+std::atomic_int tasksExecuted = 0;
+void task() {
+    tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Enqueues numBatches batches of batchSize tasks, either one task at a time or
+// with a single enqueueBulk() per batch, and waits for all of them to run.
+template<class Thread>
+std::chrono::nanoseconds
+  sampleDuration(int numBatches, int batchSize, bool bulk, Thread& th) {
+    using Task = typename Thread::Task;
+
+    tasksExecuted = 0;
+    std::vector<Task> batch(batchSize);
+    th.start();
+    Stopwatch watch;
+    for (int b = 0; b < numBatches; ++b) {
+        std::fill(batch.begin(), batch.end(), Task(task));
+        if (bulk) {
+            th.enqueueBulk(batch);
+        } else {
+            for (Task& t: batch) {
+                th.enqueue(std::move(t));
+            }
+        }
+    }
+    while (tasksExecuted != numBatches * batchSize) {
+        std::this_thread::yield();
+    }
+    auto totalDuration = watch.get();
+    th.stop();
+    return totalDuration;
+}
+
+template<class Thread>
+void printDurations(const char* name, int numBatches, int batchSize) {
+    Thread perItem;
+    Thread bulk;
+    std::cout << "\t" << name << ":\n";
+    std::cout << "\t\tenqueue:     "
+              << sampleDuration(numBatches, batchSize, false, perItem) << "\n";
+    std::cout << "\t\tenqueueBulk: "
+              << sampleDuration(numBatches, batchSize, true, bulk) << "\n";
+}
+
+int main(int argc, char** argv) {
+    constexpr int kNumTasksDefault = 10000000;
+    int numTasks = kNumTasksDefault;
+    if (argc > 1) {
+        numTasks = std::stoi(argv[1]);
+    }
+
+    for (int batchSize: {256, 4096}) {
+        const int numBatches = numTasks / batchSize;
+        std::cout << "Batches of " << batchSize << " tasks (" << numBatches
+                  << " batches):\n";
+        printDurations<EventLoopThread>("EventLoop", numBatches, batchSize);
+        printDurations<SPEventLoopThread>(
+          "SPEventLoop", numBatches, batchSize);
+        printDurations<EventLoopThreadPool>(
+          "EventLoopPool", numBatches, batchSize);
+        printDurations<SPEventLoopThreadPool>(
+          "SPEventLoopPool", numBatches, batchSize);
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <mcga/threading.hpp>
+
+#define MCGA_BENCHMARK_COUNT_ALLOCATIONS
+#include "benchmark_utils.hpp"
+
+using mcga::threading::base::DelayedQueueWrapper;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::base::PooledDelayedQueueWrapper;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::base::TimingWheelDelayedQueueWrapper;
+using mcga::threading::processors::FunctionProcessor;
+
+template<class DelayedQueue>
+using Loop = EventLoopConstruct<
+  ThreadWrapper<EventLoop<FunctionProcessor,
+                          ImmediateQueueWrapper<FunctionProcessor>,
+                          DelayedQueue>>>;
+
+using HeapEventLoopThread = Loop<DelayedQueueWrapper<FunctionProcessor>>;
+using TimingWheelEventLoopThread
+  = Loop<TimingWheelDelayedQueueWrapper<FunctionProcessor>>;
+using PooledEventLoopThread
+  = Loop<PooledDelayedQueueWrapper<FunctionProcessor>>;
+
+std::atomic_int tasksExecuted = 0;
+
+std::vector<std::chrono::milliseconds> randomDelays(int numTimers,
+                                                    int minMs,
+                                                    int maxMs) {
+    std::mt19937 generator(numTimers);
+    std::uniform_int_distribution<> distribution(minMs, maxMs);
+    std::vector<std::chrono::milliseconds> delays;
+    delays.reserve(numTimers);
+    for (int i = 0; i < numTimers; ++i) {
+        delays.emplace_back(distribution(generator));
+    }
+    return delays;
+}
+
+// Time to enqueue a timer while numTimers timers are already pending.
+template<class Thread>
+std::chrono::nanoseconds sampleInsertDuration(int numTimers) {
+    constexpr int kNumInserts = 100000;
+
+    Thread th;
+    th.start();
+    for (const auto& delay: randomDelays(numTimers, 600000, 1200000)) {
+        th.enqueueDelayed([] {}, delay);
+    }
+    auto delays = randomDelays(kNumInserts, 600000, 1200000);
+    Stopwatch watch;
+    for (const auto& delay: delays) {
+        th.enqueueDelayed([] {}, delay);
+    }
+    auto totalDuration = watch.get();
+    th.stop();
+    return totalDuration / kNumInserts;
+}
+
+// Time to execute numTimers timers, all due within the first 100ms, past the
+// 100ms themselves.
+template<class Thread>
+std::chrono::nanoseconds sampleExpireDuration(int numTimers) {
+    constexpr int kSpreadMs = 100;
+
+    tasksExecuted = 0;
+    auto delays = randomDelays(numTimers, 0, kSpreadMs);
+    Thread th;
+    Stopwatch watch;
+    for (const auto& delay: delays) {
+        th.enqueueDelayed(
+          [] {
+              tasksExecuted += 1;
+          },
+          delay);
+    }
+    th.start();
+    while (tasksExecuted != numTimers) {
+        std::this_thread::yield();
+    }
+    auto totalDuration = watch.get();
+    th.stop();
+    return totalDuration - std::chrono::milliseconds{kSpreadMs};
+}
+
+// Heap allocations per timer scheduled and executed, once the loop warmed up
+// with numTimers timers.
+template<class Thread>
+double sampleAllocationsPerTimer(int numTimers) {
+    constexpr int kSpreadMs = 10;
+
+    auto delays = randomDelays(numTimers, 0, kSpreadMs);
+    Thread th;
+    th.start();
+    std::size_t allocationsBefore = 0;
+    for (int round = 0; round < 2; ++round) {
+        tasksExecuted = 0;
+        allocationsBefore = numAllocations.load();
+        for (const auto& delay: delays) {
+            th.enqueueDelayed(
+              [] {
+                  tasksExecuted += 1;
+              },
+              delay);
+        }
+        while (tasksExecuted != numTimers) {
+            std::this_thread::yield();
+        }
+    }
+    auto allocations = numAllocations.load() - allocationsBefore;
+    th.stop();
+    return static_cast<double>(allocations) / numTimers;
+}
+
+int main() {
+    for (int numTimers: {1000, 100000, 1000000}) {
+        std::cout << numTimers << " pending timers:\n";
+        std::cout << "\tInsert, heap:                         "
+                  << sampleInsertDuration<HeapEventLoopThread>(numTimers)
+                  << "\n";
+        std::cout << "\tInsert, timing wheel:                 "
+                  << sampleInsertDuration<TimingWheelEventLoopThread>(numTimers)
+                  << "\n";
+        std::cout << "\tInsert, pooled heap:                  "
+                  << sampleInsertDuration<PooledEventLoopThread>(numTimers)
+                  << "\n";
+        std::cout << "\tExpire all (overhead), heap:          "
+                  << sampleExpireDuration<HeapEventLoopThread>(numTimers)
+                  << "\n";
+        std::cout << "\tExpire all (overhead), timing wheel:  "
+                  << sampleExpireDuration<TimingWheelEventLoopThread>(
+                       numTimers)
+                  << "\n";
+        std::cout << "\tExpire all (overhead), pooled heap:   "
+                  << sampleExpireDuration<PooledEventLoopThread>(numTimers)
+                  << "\n";
+        std::cout << "\tAllocations per timer, heap:          "
+                  << sampleAllocationsPerTimer<HeapEventLoopThread>(numTimers)
+                  << "\n";
+        std::cout << "\tAllocations per timer, timing wheel:  "
+                  << sampleAllocationsPerTimer<TimingWheelEventLoopThread>(
+                       numTimers)
+                  << "\n";
+        std::cout << "\tAllocations per timer, pooled heap:   "
+                  << sampleAllocationsPerTimer<PooledEventLoopThread>(
+                       numTimers)
+                  << "\n";
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <mcga/threading.hpp>
+
+#include "benchmark_utils.hpp"
+
+using mcga::threading::EventLoopThreadPool;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::LeastLoadedDispatch;
+using mcga::threading::base::PowerOfTwoChoicesDispatch;
+using mcga::threading::base::ThreadLocalRoundRobinDispatch;
+using mcga::threading::base::ThreadPoolWrapper;
+using mcga::threading::processors::FunctionProcessor;
+
+template<class Dispatch>
+using DispatchPool = EventLoopConstruct<
+  ThreadPoolWrapper<EventLoop<FunctionProcessor>, std::size_t, Dispatch>>;
+
+void spinFor(std::chrono::nanoseconds duration) {
+    Stopwatch watch;
+    while (watch.get() < duration) {
+    }
+}
+
+// Every producer enqueues bursts of tasks with a skewed cost, and pauses
+// between bursts so that the queues drain and refill.
+template<class Pool>
+DurationTracker sampleQueueingDelays(int numProducers,
+                                     int numBursts,
+                                     int burstSize,
+                                     std::size_t numThreads) {
+    constexpr auto kBurstPause = std::chrono::microseconds{500};
+
+    const int numTasks = numProducers * numBursts * burstSize;
+    std::vector<std::chrono::nanoseconds> delays(numTasks);
+    std::atomic_int tasksExecuted = 0;
+
+    Pool pool{typename Pool::NumThreads(numThreads)};
+    pool.start();
+    std::vector<std::thread> producers;
+    producers.reserve(numProducers);
+    for (int p = 0; p < numProducers; ++p) {
+        producers.emplace_back([&, p] {
+            std::mt19937 generator(p);
+            // One task in 16 costs 50x more than the others.
+            std::uniform_int_distribution<int> costDistribution(0, 15);
+            for (int b = 0; b < numBursts; ++b) {
+                for (int t = 0; t < burstSize; ++t) {
+                    const int i = (p * numBursts + b) * burstSize + t;
+                    const auto cost = costDistribution(generator) == 0
+                      ? std::chrono::microseconds{50}
+                      : std::chrono::microseconds{1};
+                    pool.enqueue(
+                      [&delays, &tasksExecuted, i, cost, watch = Stopwatch()] {
+                          delays[i] = watch.get();
+                          spinFor(cost);
+                          tasksExecuted += 1;
+                      });
+                }
+                std::this_thread::sleep_for(kBurstPause);
+            }
+        });
+    }
+    for (std::thread& producer: producers) {
+        producer.join();
+    }
+    while (tasksExecuted != numTasks) {
+        std::this_thread::yield();
+    }
+    pool.stop();
+
+    DurationTracker tracker;
+    for (const auto& delay: delays) {
+        tracker.addSample(delay);
+    }
+    return tracker;
+}
+
+template<class Pool>
+void printQueueingDelays(const char* name,
+                         int numProducers,
+                         int numBursts,
+                         int burstSize,
+                         std::size_t numThreads) {
+    auto tracker = sampleQueueingDelays<Pool>(
+      numProducers, numBursts, burstSize, numThreads);
+    std::cout << "\t" << name << ":\n";
+    std::cout << "\t\t50%: " << tracker.percent(50) << "\n";
+    std::cout << "\t\t99%: " << tracker.percent(99) << "\n";
+    std::cout << "\t\tmax: " << tracker.max() << "\n";
+}
+
+int main(int argc, char** argv) {
+    constexpr int kNumBurstsDefault = 200;
+    constexpr int kBurstSize = 64;
+    int numBursts = kNumBurstsDefault;
+    if (argc > 1) {
+        numBursts = std::stoi(argv[1]);
+    }
+    const std::size_t numThreads
+      = std::max(2U, std::thread::hardware_concurrency() / 2);
+    const int numProducers = static_cast<int>(numThreads);
+
+    std::cout << "Bursty load, queueing delay (" << numProducers
+              << " producers, " << numBursts << " bursts of " << kBurstSize
+              << " tasks each, " << numThreads << " threads):\n";
+    printQueueingDelays<EventLoopThreadPool>(
+      "RoundRobin", numProducers, numBursts, kBurstSize, numThreads);
+    printQueueingDelays<DispatchPool<ThreadLocalRoundRobinDispatch>>(
+      "ThreadLocalRoundRobin",
+      numProducers,
+      numBursts,
+      kBurstSize,
+      numThreads);
+    printQueueingDelays<DispatchPool<PowerOfTwoChoicesDispatch>>(
+      "PowerOfTwoChoices", numProducers, numBursts, kBurstSize, numThreads);
+    printQueueingDelays<DispatchPool<LeastLoadedDispatch>>(
+      "LeastLoaded", numProducers, numBursts, kBurstSize, numThreads);
+    return 0;
+}
@@ -1,87 +1,70 @@
-#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <thread>
 
 #include <mcga/threading.hpp>
 
-#ifdef LINK_EVPP
-#include <evpp/event_loop.h>
-#include <evpp/event_loop_thread.h>
-#endif
-
 #include "benchmark_utils.hpp"
 
 using mcga::threading::EventLoopThread;
 
-int main(int argc, char** argv) {
-    constexpr int kNumSamplesDefault = 10000;
-    int numSamples = kNumSamplesDefault;
-    if (argc > 1) {
-        numSamples = std::stoi(argv[1]);
-    }
-
+constexpr auto kDelay = std::chrono::milliseconds{3};
+
+template<class Loop>
+void enqueueDelayedTo(Loop& loop,
+                      DurationTracker* tracker,
+                      std::atomic_bool* done) {
+    Stopwatch watch;
+    auto task = [tracker, watch, done]() {
+        watch.track(tracker, kDelay);
+        done->store(true);
+    };
 #ifdef LINK_EVPP
-    DurationTracker evppTracker;
-
-    evpp::EventLoopThread evppLoop;
-    evppLoop.Start(true);
-
-    for (int i = 0; i < numSamples; ++i) {
-        Stopwatch watch;
-        bool done = false;
-        evppLoop.loop()->RunAfter(3, [&evppTracker, watch, &done]() {
-            watch.track(&evppTracker, std::chrono::milliseconds{3});
-            done = true;
-        });
-        while (!done) {
-            std::this_thread::yield();
-        }
+    if constexpr (std::is_same_v<evpp::EventLoopThread, Loop>) {
+        loop.loop()->RunAfter(
+          std::chrono::duration<double, std::milli>(kDelay).count(), task);
+        return;
     }
-
-    evppLoop.Stop(true);
-
-    evppTracker.organize();
-
-    std::cout << "EVPP event loop:\n";
-    std::cout << "\tNumber of samples: " << numSamples << "\n";
-    std::cout << "\tMinimum error: " << evppTracker.min() << ", "
-              << "Maximum error: " << evppTracker.max() << "\n\n";
-    std::cout << "\t50%: " << evppTracker.percent(50) << "\n";
-    std::cout << "\t75%: " << evppTracker.percent(75) << "\n";
-    std::cout << "\t90%: " << evppTracker.percent(90) << "\n";
-    std::cout << "\t99%: " << evppTracker.percent(99) << "\n";
 #endif
+    loop.enqueueDelayed(task, kDelay);
+}
 
-    DurationTracker tracker;
-
-    EventLoopThread loop;
-    loop.start();
-
-    for (int i = 0; i < numSamples; ++i) {
-        Stopwatch watch;
-        bool done = false;
-        loop.enqueueDelayed(
-          [&tracker, watch, &done]() {
-              watch.track(&tracker, std::chrono::milliseconds{3});
-              done = true;
-          },
-          std::chrono::milliseconds{3});
-        while (!done) {
-            std::this_thread::yield();
-        }
-    }
-
-    loop.stop();
+// Enqueues numSamples delayed tasks one after the other, each after the
+// previous one ran, and reports how late they ran as latencies.
+template<class Loop>
+void benchmark(BenchmarkHarness& harness, const std::string& variant) {
+    // Timers are enqueued one at a time from this thread, nothing to sweep.
+    harness.sweep({}, [&](const SweepPoint& point) {
+        Loop loop;
+        harness.measure(variant, point, [&](int numSamples) {
+            RunResult result;
+            startLoop(loop);
+            Stopwatch watch;
+            for (int i = 0; i < numSamples; ++i) {
+                std::atomic_bool done = false;
+                enqueueDelayedTo(loop, &result.latencies, &done);
+                while (!done) {
+                    std::this_thread::yield();
+                }
+            }
+            result.duration = watch.get();
+            stopLoop(loop);
+            return result;
+        });
+    });
+}
 
-    tracker.organize();
+int main(int argc, char** argv) {
+    constexpr int kNumSamplesDefault = 1000;
+    BenchmarkHarness harness(
+      "event_loop_delay_error", argc, argv, kNumSamplesDefault);
 
-    std::cout << "\n";
-    std::cout << "Own event loop:\n";
-    std::cout << "\tNumber of samples: " << numSamples << "\n";
-    std::cout << "\tMinimum error: " << tracker.min() << ", "
-              << "Maximum error: " << tracker.max() << "\n\n";
-    std::cout << "\t50%: " << tracker.percent(50) << "\n";
-    std::cout << "\t75%: " << tracker.percent(75) << "\n";
-    std::cout << "\t90%: " << tracker.percent(90) << "\n";
-    std::cout << "\t99%: " << tracker.percent(99) << "\n";
+    harness.section("Delayed task error, 3ms delay");
+#ifdef LINK_EVPP
+    benchmark<evpp::EventLoopThread>(harness, "EVPP EventLoop");
+#endif
+    benchmark<EventLoopThread>(harness, "EventLoop");
     return 0;
 }
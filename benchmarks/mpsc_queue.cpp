@@ -0,0 +1,117 @@
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <concurrentqueue.h>
+
+#include <mcga/threading.hpp>
+
+#include "benchmark_utils.hpp"
+
+using mcga::threading::EventLoopThread;
+using mcga::threading::EventLoopThreadPool;
+using mcga::threading::MPSCEventLoopThread;
+using mcga::threading::MPSCEventLoopThreadPool;
+using mcga::threading::base::MPSCQueue;
+
+std::atomic_int tasksExecuted = 0;
+void task() {
+    tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The queues alone, without a loop around them: one consumer thread drains
+// the queue in batches, the way an event loop does.
+template<class Queue>
+class DrainedQueue {
+  private:
+    static constexpr std::size_t kBatchSize = 1024;
+
+  public:
+    void start() {
+        running = true;
+        consumer = std::thread([this] {
+            std::array<int, kBatchSize> batch;
+            while (running.load(std::memory_order_relaxed)) {
+                auto count = queue.tryDequeueBulk(batch.begin(), kBatchSize);
+                tasksExecuted.fetch_add(static_cast<int>(count),
+                                        std::memory_order_relaxed);
+            }
+        });
+    }
+
+    void stop() {
+        running = false;
+        consumer.join();
+    }
+
+    void enqueue(int value) {
+        queue.enqueue(value);
+    }
+
+  private:
+    Queue queue;
+    std::atomic_bool running = false;
+    std::thread consumer;
+};
+
+// moodycamel::ConcurrentQueue used the way ImmediateQueueWrapper does.
+class ConcurrentQueue {
+  public:
+    void enqueue(int value) {
+        queue.enqueue(std::move(value));
+    }
+
+    template<class It>
+    std::size_t tryDequeueBulk(It it, std::size_t maxCount) {
+        return queue.try_dequeue_bulk(token, it, maxCount);
+    }
+
+  private:
+    moodycamel::ConcurrentQueue<int> queue;
+    moodycamel::ConsumerToken token{queue};
+};
+
+template<class Loop, class Enqueue>
+void benchmark(BenchmarkHarness& harness,
+               const std::string& variant,
+               const Enqueue& enqueue) {
+    const SweepAxes axes{.producers = true, .threads = kIsPool<Loop>};
+    harness.sweep(axes, [&](const SweepPoint& point) {
+        auto loop = makeLoop<Loop>(point);
+        harness.measure(variant, point, [&](int numTasks) {
+            tasksExecuted = 0;
+            return runTasks(*loop, numTasks, point, enqueue, [numTasks] {
+                return tasksExecuted.load() == numTasks;
+            });
+        });
+    });
+}
+
+int main(int argc, char** argv) {
+    constexpr int kNumSamplesDefault = 10000000;
+    BenchmarkHarness harness(
+      "mpsc_queue", argc, argv, kNumSamplesDefault, {}, {1, 4, 16, 64});
+
+    auto enqueueValue = [](auto& queue, int i) {
+        queue.enqueue(i);
+    };
+    auto enqueueTask = [](auto& loop, int /*i*/) {
+        enqueueTo(loop, &task);
+    };
+
+    harness.section("Queue");
+    benchmark<DrainedQueue<ConcurrentQueue>>(
+      harness, "ConcurrentQueue", enqueueValue);
+    benchmark<DrainedQueue<MPSCQueue<int>>>(
+      harness, "MPSCQueue", enqueueValue);
+
+    harness.section("Event loop");
+    benchmark<EventLoopThread>(harness, "EventLoop", enqueueTask);
+    benchmark<MPSCEventLoopThread>(harness, "MPSCEventLoop", enqueueTask);
+    benchmark<EventLoopThreadPool>(harness, "EventLoopPool", enqueueTask);
+    benchmark<MPSCEventLoopThreadPool>(
+      harness, "MPSCEventLoopPool", enqueueTask);
+    return 0;
+}
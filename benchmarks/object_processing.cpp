@@ -1,21 +1,18 @@
 #include <iostream>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include <mcga/threading.hpp>
 
-#ifdef LINK_EVPP
-#include <evpp/event_loop.h>
-#include <evpp/event_loop_thread.h>
-#include <evpp/event_loop_thread_pool.h>
-#endif
-
 #include "benchmark_utils.hpp"
 
 using mcga::threading::EventLoopThread;
 using mcga::threading::EventLoopThreadPool;
 using mcga::threading::ObjectEventLoopThread;
 using mcga::threading::ObjectEventLoopThreadPool;
+using mcga::threading::ObjectSharedQueueEventLoopThreadPool;
 
 int tasksExecuted = 0;
 void task(int /*obj*/) {
@@ -61,416 +58,190 @@ void atomicTripleTaskCapture(int /*obj1*/,
     atomicTasksExecuted += 1;
 }
 
-template<class Thread>
-std::chrono::nanoseconds sampleDuration(int numSamples, Thread& th) {
-    tasksExecuted = 0;
-    atomicTasksExecuted = 0;
+// Measures Loop on every sweep point, enqueueing makeTask(i, isPool) as task
+// i. Pool tasks must increment the atomic counter.
+template<class Loop, class MakeTask, class... Args>
+void benchmark(BenchmarkHarness& harness,
+               const std::string& variant,
+               const MakeTask& makeTask,
+               Args&... args) {
+    const SweepAxes axes{.producers = !kIsSingleProducer<Loop>,
+                         .threads = kIsPool<Loop>};
+    harness.sweep(axes, [&](const SweepPoint& point) {
+        auto loop = makeLoop<Loop>(point, args...);
+        harness.measure(variant, point, [&](int numTasks) {
+            tasksExecuted = 0;
+            atomicTasksExecuted = 0;
+            return runTasks(
+              *loop,
+              numTasks,
+              point,
+              [&makeTask](Loop& loop, int i) {
+                  enqueueTo(loop,
+                            makeTask(i, std::bool_constant<kIsPool<Loop>>()));
+              },
+              [numTasks] {
+                  return tasksExecuted == numTasks
+                    || atomicTasksExecuted == numTasks;
+              });
+        });
+    });
+}
 
-#ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Start(true);
-    } else
-#endif
-        th.start();
-    Stopwatch watch;
-    for (int i = 0; i < numSamples; ++i) {
-#ifdef LINK_EVPP
-        if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Thread>) {
-            th.GetNextLoop()->QueueInLoop([i] {
-                atomicTask(i);
-            });
-        } else if constexpr (std::is_same_v<evpp::EventLoopThread, Thread>) {
-            th.loop()->QueueInLoop([i] {
-                task(i);
-            });
-        } else
-#endif
-          if constexpr (std::is_base_of_v<EventLoopThreadPool, Thread>) {
-            th.enqueue([i] {
+int main(int argc, char** argv) {
+    constexpr int kNumSamplesDefault = 10000000;
+    BenchmarkHarness harness(
+      "object_processing", argc, argv, kNumSamplesDefault);
+
+    auto singleObject = [](int i, auto /*isPool*/) {
+        return i;
+    };
+    auto singleLambda = [](int i, auto isPool) {
+        if constexpr (isPool) {
+            return [i] {
                 atomicTask(i);
-            });
-        } else if constexpr (std::is_base_of_v<EventLoopThread, Thread>) {
-            th.enqueue([i] {
-                task(i);
-            });
+            };
         } else {
-            th.enqueue(i);
+            return [i] {
+                task(i);
+            };
         }
-    }
-    while (tasksExecuted != numSamples && atomicTasksExecuted != numSamples) {
-        std::this_thread::yield();
-    }
-    auto totalDuration = watch.get();
-
-#ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Stop(true);
-    } else
-#endif
-        th.stop();
-    return totalDuration;
-}
-
-template<class Thread>
-std::chrono::nanoseconds sampleDurationCapture(int numSamples,
-                                               Thread& th,
-                                               int& capture1,
-                                               std::vector<int> capture2,
-                                               const double& capture3) {
-    tasksExecuted = 0;
-    atomicTasksExecuted = 0;
+    };
 
+    harness.section("No state, single object");
 #ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Start(true);
-    } else
+    benchmark<evpp::EventLoopThread>(harness, "EVPP EventLoop", singleLambda);
 #endif
-        th.start();
-    Stopwatch watch;
-    for (int i = 0; i < numSamples; ++i) {
+    benchmark<EventLoopThread>(harness, "EventLoop", singleLambda);
+    benchmark<ObjectEventLoopThread<int>>(
+      harness, "ObjectEventLoop", singleObject, task);
 #ifdef LINK_EVPP
-        if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Thread>) {
-            th.GetNextLoop()->QueueInLoop([i, &capture1, &capture2, &capture3] {
-                atomicCaptureTask(i, capture1, capture2, capture3);
-            });
-        } else if constexpr (std::is_same_v<evpp::EventLoopThread, Thread>) {
-            th.loop()->QueueInLoop([i, &capture1, &capture2, &capture3] {
-                captureTask(i, capture1, capture2, capture3);
-            });
-        } else
+    benchmark<evpp::EventLoopThreadPool>(
+      harness, "EVPP EventLoopPool", singleLambda);
 #endif
-          if constexpr (std::is_base_of_v<EventLoopThreadPool, Thread>) {
-            th.enqueue([i, &capture1, &capture2, &capture3] {
+    benchmark<EventLoopThreadPool>(harness, "EventLoopPool", singleLambda);
+    benchmark<ObjectEventLoopThreadPool<int>>(
+      harness, "ObjectEventLoopPool", singleObject, atomicTask);
+    benchmark<ObjectSharedQueueEventLoopThreadPool<int>>(
+      harness, "ObjectSharedQueuePool", singleObject, atomicTask);
+
+    int capture1 = 0;
+    std::vector<int> capture2(20, 0);
+    double capture3 = 3.14;
+
+    auto captureLambda = [&](int i, auto isPool) {
+        if constexpr (isPool) {
+            return [i, &capture1, &capture2, &capture3] {
                 atomicCaptureTask(i, capture1, capture2, capture3);
-            });
-        } else if constexpr (std::is_base_of_v<EventLoopThread, Thread>) {
-            th.enqueue([i, &capture1, &capture2, &capture3] {
-                captureTask(i, capture1, capture2, capture3);
-            });
+            };
         } else {
-            th.enqueue(i);
+            return [i, &capture1, &capture2, &capture3] {
+                captureTask(i, capture1, capture2, capture3);
+            };
         }
-    }
-    while (tasksExecuted != numSamples && atomicTasksExecuted != numSamples) {
-        std::this_thread::yield();
-    }
-    auto totalDuration = watch.get();
+    };
+    auto captureProcessor = [&](int obj) {
+        captureTask(obj, capture1, capture2, capture3);
+    };
+    auto atomicCaptureProcessor = [&](int obj) {
+        atomicCaptureTask(obj, capture1, capture2, capture3);
+    };
 
+    harness.section("With state (3x reference capture), single object");
 #ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Stop(true);
-    } else
+    benchmark<evpp::EventLoopThread>(harness, "EVPP EventLoop", captureLambda);
 #endif
-        th.stop();
-    return totalDuration;
-}
-
-template<class Thread>
-std::chrono::nanoseconds sampleDurationTriple(int numSamples, Thread& th) {
-    tasksExecuted = 0;
-    atomicTasksExecuted = 0;
+    benchmark<EventLoopThread>(harness, "EventLoop", captureLambda);
+    benchmark<ObjectEventLoopThread<int>>(
+      harness, "ObjectEventLoop", singleObject, captureProcessor);
+#ifdef LINK_EVPP
+    benchmark<evpp::EventLoopThreadPool>(
+      harness, "EVPP EventLoopPool", captureLambda);
+#endif
+    benchmark<EventLoopThreadPool>(harness, "EventLoopPool", captureLambda);
+    benchmark<ObjectEventLoopThreadPool<int>>(
+      harness, "ObjectEventLoopPool", singleObject, atomicCaptureProcessor);
+    benchmark<ObjectSharedQueueEventLoopThreadPool<int>>(
+      harness, "ObjectSharedQueuePool", singleObject, atomicCaptureProcessor);
 
     double d = 3.14;
 
-#ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Start(true);
-    } else
-#endif
-        th.start();
-    Stopwatch watch;
-    for (int i = 0; i < numSamples; ++i) {
-#ifdef LINK_EVPP
-        if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Thread>) {
-            th.GetNextLoop()->QueueInLoop([i, j = 3 * i, &d] {
+    auto tripleObject = [&d](int i, auto /*isPool*/) {
+        return std::tuple<int, int, const double*>(i, 3 * i, &d);
+    };
+    auto tripleLambda = [&d](int i, auto isPool) {
+        if constexpr (isPool) {
+            return [i, j = 3 * i, &d] {
                 tripleAtomicTask(i, j, &d);
-            });
-        } else if constexpr (std::is_same_v<evpp::EventLoopThread, Thread>) {
-            th.loop()->QueueInLoop([i, j = 3 * i, &d] {
-                tripleTask(i, j, &d);
-            });
-        } else
-#endif
-          if constexpr (std::is_base_of_v<EventLoopThreadPool, Thread>) {
-            th.enqueue([i, j = 3 * i, &d] {
-                tripleAtomicTask(i, j, &d);
-            });
-        } else if constexpr (std::is_base_of_v<EventLoopThread, Thread>) {
-            th.enqueue([i, j = 3 * i, &d] {
-                tripleTask(i, j, &d);
-            });
+            };
         } else {
-            th.enqueue({i, 3 * i, &d});
+            return [i, j = 3 * i, &d] {
+                tripleTask(i, j, &d);
+            };
         }
-    }
-    while (tasksExecuted != numSamples && atomicTasksExecuted != numSamples) {
-        std::this_thread::yield();
-    }
-    auto totalDuration = watch.get();
-
-#ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Stop(true);
-    } else
-#endif
-        th.stop();
-    return totalDuration;
-}
-
-template<class Thread>
-std::chrono::nanoseconds sampleDurationTripleCapture(int numSamples,
-                                                     Thread& th,
-                                                     int& capture1,
-                                                     std::vector<int> capture2,
-                                                     const double& capture3) {
-    tasksExecuted = 0;
-    atomicTasksExecuted = 0;
-
-    double d = 3.14;
+    };
 
+    harness.section("No state, 3 objects");
 #ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Start(true);
-    } else
+    benchmark<evpp::EventLoopThread>(harness, "EVPP EventLoop", tripleLambda);
 #endif
-        th.start();
-    Stopwatch watch;
-    for (int i = 0; i < numSamples; ++i) {
+    benchmark<EventLoopThread>(harness, "EventLoop", tripleLambda);
+    benchmark<ObjectEventLoopThread<int, int, const double*>>(
+      harness, "ObjectEventLoop", tripleObject, tripleTask);
 #ifdef LINK_EVPP
-        if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Thread>) {
-            th.GetNextLoop()->QueueInLoop(
-              [i, j = 3 * i, &d, &capture1, &capture2, &capture3] {
-                  atomicTripleTaskCapture(
-                    i, j, &d, capture1, capture2, capture3);
-              });
-        } else if constexpr (std::is_same_v<evpp::EventLoopThread, Thread>) {
-            th.loop()->QueueInLoop(
-              [i, j = 3 * i, &d, &capture1, &capture2, &capture3] {
-                  tripleTaskCapture(i, j, &d, capture1, capture2, capture3);
-              });
-        } else
+    benchmark<evpp::EventLoopThreadPool>(
+      harness, "EVPP EventLoopPool", tripleLambda);
 #endif
-          if constexpr (std::is_base_of_v<EventLoopThreadPool, Thread>) {
-            th.enqueue([i, j = 3 * i, &d, &capture1, &capture2, &capture3] {
+    benchmark<EventLoopThreadPool>(harness, "EventLoopPool", tripleLambda);
+    benchmark<ObjectEventLoopThreadPool<int, int, const double*>>(
+      harness, "ObjectEventLoopPool", tripleObject, tripleAtomicTask);
+    benchmark<ObjectSharedQueueEventLoopThreadPool<int, int, const double*>>(
+      harness, "ObjectSharedQueuePool", tripleObject, tripleAtomicTask);
+
+    auto tripleCaptureLambda = [&](int i, auto isPool) {
+        if constexpr (isPool) {
+            return [i, j = 3 * i, &d, &capture1, &capture2, &capture3] {
                 atomicTripleTaskCapture(i, j, &d, capture1, capture2, capture3);
-            });
-        } else if constexpr (std::is_base_of_v<EventLoopThread, Thread>) {
-            th.enqueue([i, j = 3 * i, &d, &capture1, &capture2, &capture3] {
-                tripleTaskCapture(i, j, &d, capture1, capture2, capture3);
-            });
+            };
         } else {
-            th.enqueue({i, 3 * i, &d});
+            return [i, j = 3 * i, &d, &capture1, &capture2, &capture3] {
+                tripleTaskCapture(i, j, &d, capture1, capture2, capture3);
+            };
         }
-    }
-    while (tasksExecuted != numSamples && atomicTasksExecuted != numSamples) {
-        std::this_thread::yield();
-    }
-    auto totalDuration = watch.get();
-
-#ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Stop(true);
-    } else
-#endif
-        th.stop();
-    return totalDuration;
-}
-
-int main(int argc, char** argv) {
-    constexpr int kNumSamplesDefault = 10000000;
-    int numSamples = kNumSamplesDefault;
-    if (argc > 1) {
-        numSamples = std::stoi(argv[1]);
-    }
-
-#ifdef LINK_EVPP
-    evpp::EventLoopThread evppEventLoop1;
-    evpp::EventLoopThread evppEventLoop2;
-    evpp::EventLoopThread evppEventLoop3;
-    evpp::EventLoopThread evppEventLoop4;
-#endif
-    EventLoopThread eventLoop;
-
-#ifdef LINK_EVPP
-    evpp::EventLoopThreadPool evppEventLoopPool1(
-      nullptr, std::thread::hardware_concurrency());
-    evpp::EventLoopThreadPool evppEventLoopPool2(
-      nullptr, std::thread::hardware_concurrency());
-    evpp::EventLoopThreadPool evppEventLoopPool3(
-      nullptr, std::thread::hardware_concurrency());
-    evpp::EventLoopThreadPool evppEventLoopPool4(
-      nullptr, std::thread::hardware_concurrency());
-#endif
-    EventLoopThreadPool eventLoopPool;
-
-    ObjectEventLoopThread<int> objectEventLoop(task);
-    ObjectEventLoopThreadPool<int> objectEventLoopPool(atomicTask);
-
-    std::cout << "No state, single object (" << numSamples << " samples):\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoop:         "
-              << sampleDuration(numSamples, evppEventLoop1) << "\n";
-#endif
-    std::cout << "\tEventLoop:              "
-              << sampleDuration(numSamples, eventLoop) << "\n";
-    std::cout << "\tObjectEventLoop:        "
-              << sampleDuration(numSamples, objectEventLoop) << "\n";
-    std::cout << "\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoopPool:     "
-              << sampleDuration(numSamples, evppEventLoopPool1) << "\n";
-#endif
-    std::cout << "\tEventLoopPool:          "
-              << sampleDuration(numSamples, eventLoopPool) << "\n";
-    std::cout << "\tObjectEventLoopPool:    "
-              << sampleDuration(numSamples, objectEventLoopPool) << "\n";
-
-    std::cout << "\n\n";
-
-    int capture1 = 0;
-    std::vector<int> capture2(20, 0);
-    double capture3 = 3.14;
-
-    ObjectEventLoopThread<int> captureObjectEventLoop(
-      [&capture1, &capture2, &capture3](int obj) {
-          captureTask(obj, capture1, capture2, capture3);
-      });
-    ObjectEventLoopThreadPool<int> captureObjectEventLoopPool(
-      [&capture1, &capture2, &capture3](int obj) {
-          atomicCaptureTask(obj, capture1, capture2, capture3);
-      });
-
-    std::cout << "With state (3x reference capture), single object ("
-              << numSamples << " samples):\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoop:         "
-              << sampleDurationCapture(
-                   numSamples, evppEventLoop2, capture1, capture2, capture3)
-              << "\n";
-#endif
-    std::cout << "\tEventLoop:              "
-              << sampleDurationCapture(
-                   numSamples, eventLoop, capture1, capture2, capture3)
-              << "\n";
-    std::cout << "\tObjectEventLoop:        "
-              << sampleDurationCapture(
-                   numSamples, objectEventLoop, capture1, capture2, capture3)
-              << "\n";
-    std::cout << "\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoopPool:     "
-              << sampleDurationCapture(
-                   numSamples, evppEventLoopPool2, capture1, capture2, capture3)
-              << "\n";
-#endif
-    std::cout << "\tEventLoopPool:          "
-              << sampleDurationCapture(
-                   numSamples, eventLoopPool, capture1, capture2, capture3)
-              << "\n";
-    std::cout << "\tObjectEventLoopPool:    "
-              << sampleDurationCapture(numSamples,
-                                       objectEventLoopPool,
-                                       capture1,
-                                       capture2,
-                                       capture3)
-              << "\n";
-
-    std::cout << "\n\n";
-
-    ObjectEventLoopThread<int, int, const double*> tripleObjectEventLoop(
-      tripleTask);
-    ObjectEventLoopThreadPool<int, int, const double*>
-      tripleObjectEventLoopPool(tripleAtomicTask);
-
-    std::cout << "No state, 3 objects (" << numSamples << " samples):\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoop:         "
-              << sampleDurationTriple(numSamples, evppEventLoop3) << "\n";
-#endif
-    std::cout << "\tEventLoop:              "
-              << sampleDurationTriple(numSamples, eventLoop) << "\n";
-    std::cout << "\tObjectEventLoop:        "
-              << sampleDurationTriple(numSamples, tripleObjectEventLoop)
-              << "\n";
-    std::cout << "\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoopPool:     "
-              << sampleDurationTriple(numSamples, evppEventLoopPool3) << "\n";
-#endif
-    std::cout << "\tEventLoopPool:          "
-              << sampleDurationTriple(numSamples, eventLoopPool) << "\n";
-    std::cout << "\tObjectEventLoopPool:    "
-              << sampleDurationTriple(numSamples, tripleObjectEventLoopPool)
-              << "\n";
-
-    std::cout << "\n\n";
-
-    ObjectEventLoopThread<int, int, const double*> tripleObjectCaptureEventLoop(
-      [&capture1, &capture2, &capture3](
-        int obj1, int obj2, const double* obj3) {
-          tripleTaskCapture(obj1, obj2, obj3, capture1, capture2, capture3);
-      });
-    ObjectEventLoopThreadPool<int, int, const double*>
-      tripleObjectCaptureEventLoopPool(
-        [&capture1, &capture2, &capture3](
-          int obj1, int obj2, const double* obj3) {
+    };
+    auto tripleCaptureProcessor
+      = [&](int obj1, int obj2, const double* obj3) {
+            tripleTaskCapture(obj1, obj2, obj3, capture1, capture2, capture3);
+        };
+    auto atomicTripleCaptureProcessor
+      = [&](int obj1, int obj2, const double* obj3) {
             atomicTripleTaskCapture(
               obj1, obj2, obj3, capture1, capture2, capture3);
-        });
-
-    std::cout << "With state (3x reference capture), 3 objects (" << numSamples
-              << " samples):\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoop:         "
-              << sampleDurationTripleCapture(
-                   numSamples, evppEventLoop4, capture1, capture2, capture3)
-              << "\n";
-#endif
-    std::cout << "\tEventLoop:              "
-              << sampleDurationTripleCapture(
-                   numSamples, eventLoop, capture1, capture2, capture3)
-              << "\n";
-    std::cout << "\tObjectEventLoop:        "
-              << sampleDurationTripleCapture(numSamples,
-                                             tripleObjectCaptureEventLoop,
-                                             capture1,
-                                             capture2,
-                                             capture3)
-              << "\n";
-    std::cout << "\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoopPool:     "
-              << sampleDurationTripleCapture(
-                   numSamples, evppEventLoopPool4, capture1, capture2, capture3)
-              << "\n";
-#endif
-    std::cout << "\tEventLoopPool:          "
-              << sampleDurationTripleCapture(
-                   numSamples, eventLoopPool, capture1, capture2, capture3)
-              << "\n";
-    std::cout << "\tObjectEventLoopPool:    "
-              << sampleDurationTripleCapture(numSamples,
-                                             tripleObjectCaptureEventLoopPool,
-                                             capture1,
-                                             capture2,
-                                             capture3)
-              << "\n";
-
+        };
+
+    harness.section("With state (3x reference capture), 3 objects");
+#ifdef LINK_EVPP
+    benchmark<evpp::EventLoopThread>(
+      harness, "EVPP EventLoop", tripleCaptureLambda);
+#endif
+    benchmark<EventLoopThread>(harness, "EventLoop", tripleCaptureLambda);
+    benchmark<ObjectEventLoopThread<int, int, const double*>>(
+      harness, "ObjectEventLoop", tripleObject, tripleCaptureProcessor);
+#ifdef LINK_EVPP
+    benchmark<evpp::EventLoopThreadPool>(
+      harness, "EVPP EventLoopPool", tripleCaptureLambda);
+#endif
+    benchmark<EventLoopThreadPool>(
+      harness, "EventLoopPool", tripleCaptureLambda);
+    benchmark<ObjectEventLoopThreadPool<int, int, const double*>>(
+      harness,
+      "ObjectEventLoopPool",
+      tripleObject,
+      atomicTripleCaptureProcessor);
+    benchmark<ObjectSharedQueueEventLoopThreadPool<int, int, const double*>>(
+      harness,
+      "ObjectSharedQueuePool",
+      tripleObject,
+      atomicTripleCaptureProcessor);
     return 0;
 }
@@ -1,21 +1,24 @@
+#include <array>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <mcga/threading.hpp>
 
-#ifdef LINK_EVPP
-#include <evpp/event_loop.h>
-#include <evpp/event_loop_thread.h>
-#include <evpp/event_loop_thread_pool.h>
-#endif
-
+#define MCGA_BENCHMARK_COUNT_ALLOCATIONS
 #include "benchmark_utils.hpp"
 
 using mcga::threading::EventLoopThread;
 using mcga::threading::EventLoopThreadPool;
+using mcga::threading::InplaceEventLoopThread;
+using mcga::threading::InplaceEventLoopThreadPool;
 using mcga::threading::SPEventLoopThread;
 using mcga::threading::SPEventLoopThreadPool;
+using mcga::threading::SharedQueueEventLoopThreadPool;
 using mcga::threading::StatefulEventLoopThread;
 using mcga::threading::StatefulEventLoopThreadPool;
 using mcga::threading::StatefulSPEventLoopThread;
@@ -24,6 +27,7 @@ using mcga::threading::StatelessEventLoopThread;
 using mcga::threading::StatelessEventLoopThreadPool;
 using mcga::threading::StatelessSPEventLoopThread;
 using mcga::threading::StatelessSPEventLoopThreadPool;
+using mcga::threading::StatelessSharedQueueEventLoopThreadPool;
 
 int tasksExecuted = 0;
 void task() {
@@ -35,178 +39,215 @@ void atomicTask() {
     atomicTasksExecuted += 1;
 }
 
-template<class Thread, class Task>
-std::chrono::nanoseconds
-  sampleDuration(int numSamples, const Task& task, Thread& th) {
-    tasksExecuted = 0;
-    atomicTasksExecuted = 0;
-
-#ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Start(true);
-    } else
-#endif
-        th.start();
-    Stopwatch watch;
-    for (int i = 0; i < numSamples; ++i) {
-#ifdef LINK_EVPP
-        if constexpr (std::is_same_v<evpp::EventLoopThreadPool, Thread>) {
-            th.GetNextLoop()->QueueInLoop(task);
-        } else if constexpr (std::is_same_v<evpp::EventLoopThread, Thread>) {
-            th.loop()->QueueInLoop(task);
-        } else
-#endif
-            th.enqueue(task);
+// The largest task size swept, InplaceFunction capacity included.
+constexpr std::size_t kMaxTaskSize = 256;
+
+// A task capturing exactly Size bytes: the counter it increments, and
+// padding.
+template<std::size_t Size, class Counter>
+auto makeCapturingTask(Counter* counter) {
+    static_assert(Size >= sizeof(Counter*) && Size % sizeof(Counter*) == 0);
+    if constexpr (Size == sizeof(Counter*)) {
+        return [counter] {
+            *counter += 1;
+        };
+    } else {
+        using Padding = std::array<char, Size - sizeof(Counter*)>;
+        return [counter, padding = Padding{}] {
+            static_cast<void>(padding);
+            *counter += 1;
+        };
     }
-    while (tasksExecuted != numSamples && atomicTasksExecuted != numSamples) {
-        std::this_thread::yield();
+}
+
+// Calls run(task), with a task capturing point.taskSize bytes.
+template<class Counter, class Run>
+void withCapturingTask(const SweepPoint& point,
+                       Counter* counter,
+                       const Run& run) {
+    switch (point.taskSize) {
+        case 8: return run(makeCapturingTask<8>(counter));
+        case 16: return run(makeCapturingTask<16>(counter));
+        case 32: return run(makeCapturingTask<32>(counter));
+        case 64: return run(makeCapturingTask<64>(counter));
+        case 128: return run(makeCapturingTask<128>(counter));
+        case kMaxTaskSize: return run(makeCapturingTask<kMaxTaskSize>(counter));
+        default:
+            std::cerr << "Unsupported task size " << point.taskSize
+                      << ", use 8, 16, 32, 64, 128 or 256.\n";
+            std::exit(1);
     }
-    auto totalDuration = watch.get();
+}
 
-#ifdef LINK_EVPP
-    if constexpr (std::is_same_v<
-                    evpp::EventLoopThreadPool,
-                    Thread> || std::is_same_v<evpp::EventLoopThread, Thread>) {
-        th.Stop(true);
-    } else
-#endif
-        th.stop();
-    return totalDuration;
+// Measures Loop on every sweep point. withTask(point, counter, run) calls
+// run(task) with the task to enqueue, counter being the one the loop's tasks
+// must increment: plain for single threads, atomic for pools.
+template<class Loop, class WithTask, class... Args>
+void benchmark(BenchmarkHarness& harness,
+               const std::string& variant,
+               bool sweepsTaskSizes,
+               const WithTask& withTask,
+               Args&... args) {
+    const SweepAxes axes{.producers = !kIsSingleProducer<Loop>,
+                         .threads = kIsPool<Loop>,
+                         .taskSizes = sweepsTaskSizes};
+    harness.sweep(axes, [&](const SweepPoint& point) {
+        auto loop = makeLoop<Loop>(point, args...);
+        auto measure = [&](const auto& task) {
+            harness.measure(variant, point, [&](int numTasks) {
+                tasksExecuted = 0;
+                atomicTasksExecuted = 0;
+                auto allocationsBefore = numAllocations.load();
+                RunResult result = runTasks(
+                  *loop,
+                  numTasks,
+                  point,
+                  [&task](Loop& loop, int /*i*/) {
+                      enqueueTo(loop, task);
+                  },
+                  [numTasks] {
+                      return tasksExecuted == numTasks
+                        || atomicTasksExecuted == numTasks;
+                  });
+                result.allocationsPerTask
+                  = static_cast<double>(numAllocations.load()
+                                        - allocationsBefore)
+                  / numTasks;
+                return result;
+            });
+        };
+        if constexpr (kIsPool<Loop>) {
+            withTask(point, &atomicTasksExecuted, measure);
+        } else {
+            withTask(point, &tasksExecuted, measure);
+        }
+    });
 }
 
 int main(int argc, char** argv) {
     constexpr int kNumSamplesDefault = 10000000;
-    int numSamples = kNumSamplesDefault;
-    if (argc > 1) {
-        numSamples = std::stoi(argv[1]);
-    }
+    BenchmarkHarness harness(
+      "simple_function", argc, argv, kNumSamplesDefault, {32});
+
+    auto functionPointer = [](const SweepPoint& /*point*/,
+                              const auto* counter,
+                              const auto& run) {
+        if constexpr (std::is_same_v<decltype(counter), const int*>) {
+            run(&task);
+        } else {
+            run(&atomicTask);
+        }
+    };
+    auto capturing
+      = [](const SweepPoint& point, auto* counter, const auto& run) {
+            withCapturingTask(point, counter, run);
+        };
 
+    harness.section("Non-capturing");
 #ifdef LINK_EVPP
-    evpp::EventLoopThread evppEventLoop1;
-    evpp::EventLoopThread evppEventLoop2;
+    benchmark<evpp::EventLoopThread>(
+      harness, "EVPP EventLoop", false, functionPointer);
 #endif
-    EventLoopThread eventLoop;
-    StatelessEventLoopThread statelessEventLoop;
-    SPEventLoopThread spEventLoop;
-    StatelessSPEventLoopThread spStatelessEventLoop;
-
+    benchmark<EventLoopThread>(harness, "EventLoop", false, functionPointer);
+    benchmark<StatelessEventLoopThread>(
+      harness, "StatelessEventLoop", false, functionPointer);
+    benchmark<SPEventLoopThread>(
+      harness, "SPEventLoop", false, functionPointer);
+    benchmark<StatelessSPEventLoopThread>(
+      harness, "StatelessSPEventLoop", false, functionPointer);
 #ifdef LINK_EVPP
-    evpp::EventLoopThreadPool evppEventLoopPool1(
-      nullptr, std::thread::hardware_concurrency());
-    evpp::EventLoopThreadPool evppEventLoopPool2(
-      nullptr, std::thread::hardware_concurrency());
+    benchmark<evpp::EventLoopThreadPool>(
+      harness, "EVPP EventLoopPool", false, functionPointer);
 #endif
-    EventLoopThreadPool eventLoopPool;
-    StatelessEventLoopThreadPool statelessEventLoopPool;
-    SPEventLoopThreadPool spEventLoopPool;
-    StatelessSPEventLoopThreadPool spStatelessEventLoopPool;
-
+    benchmark<EventLoopThreadPool>(
+      harness, "EventLoopPool", false, functionPointer);
+    benchmark<StatelessEventLoopThreadPool>(
+      harness, "StatelessEventLoopPool", false, functionPointer);
+    benchmark<SPEventLoopThreadPool>(
+      harness, "SPEventLoopPool", false, functionPointer);
+    benchmark<StatelessSPEventLoopThreadPool>(
+      harness, "StatelessSPEventLoopPool", false, functionPointer);
+    benchmark<SharedQueueEventLoopThreadPool>(
+      harness, "SharedQueueEventLoopPool", false, functionPointer);
+    benchmark<StatelessSharedQueueEventLoopThreadPool>(
+      harness, "StatelessSharedQueueEventLoopPool", false, functionPointer);
+
+    // The stateful loops pass the state to every task as arguments, instead
+    // of the tasks capturing it.
     int capture = 1;
     std::vector<int> capture2(30, 0);
     double capture3 = 3.14;
-    auto capturingLambda = [&capture, capture2, &capture3] {
-        tasksExecuted += capture;
-    };
-    auto atomicCapturingLambda = [&capture, capture2, &capture3] {
-        atomicTasksExecuted += capture;
+    auto parameterTask = [](const SweepPoint& /*point*/,
+                            const auto* counter,
+                            const auto& run) {
+        if constexpr (std::is_same_v<decltype(counter), const int*>) {
+            run(+[](int& capture,
+                    std::vector<int> /*unused*/,
+                    const double& /*unused*/) {
+                tasksExecuted += capture;
+            });
+        } else {
+            run(+[](int& capture,
+                    std::vector<int> /*unused*/,
+                    const double& /*unused*/) {
+                atomicTasksExecuted += capture;
+            });
+        }
     };
 
-    auto parameterLambda =
-      [](int& capture, std::vector<int> /*unused*/, const double& /*unused*/) {
-          tasksExecuted += capture;
-      };
-
-    auto atomicParameterLambda =
-      [](int& capture, std::vector<int> /*unused*/, const double& /*unused*/) {
-          atomicTasksExecuted += capture;
-      };
-
-    StatefulEventLoopThread<int&, std::vector<int>, const double&>
-      statefulEventLoop(capture, capture2, capture3);
-    StatefulEventLoopThreadPool<int&, std::vector<int>, const double&>
-      statefulEventLoopPool(capture, capture2, capture3);
-    StatefulSPEventLoopThread<int&, std::vector<int>, const double&>
-      spStatefulEventLoop(capture, capture2, capture3);
-    StatefulSPEventLoopThreadPool<int&, std::vector<int>, const double&>
-      spStatefulEventLoopPool(capture, capture2, capture3);
-
-    std::cout << "Non-capturing (" << numSamples << " samples):\n";
+    harness.section("Capturing");
 #ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoop:                       "
-              << sampleDuration(numSamples, task, evppEventLoop1) << "\n";
+    benchmark<evpp::EventLoopThread>(
+      harness, "EVPP EventLoop", true, capturing);
 #endif
-    std::cout << "\tEventLoop:                            "
-              << sampleDuration(numSamples, task, eventLoop) << "\n";
-    std::cout << "\tStatelessEventLoop:                   "
-              << sampleDuration(numSamples, task, statelessEventLoop) << "\n";
-    std::cout << "\tSPEventLoop:                          "
-              << sampleDuration(numSamples, task, spEventLoop) << "\n";
-    std::cout << "\tStatelessSPEventLoop:                 "
-              << sampleDuration(numSamples, task, spStatelessEventLoop) << "\n";
-    std::cout << "\n";
+    benchmark<EventLoopThread>(harness, "EventLoop", true, capturing);
+    benchmark<SPEventLoopThread>(harness, "SPEventLoop", true, capturing);
+    benchmark<InplaceEventLoopThread<kMaxTaskSize>>(
+      harness, "InplaceEventLoop", true, capturing);
+    benchmark<StatefulEventLoopThread<int&, std::vector<int>, const double&>>(
+      harness,
+      "StatefulEventLoop",
+      false,
+      parameterTask,
+      capture,
+      capture2,
+      capture3);
+    benchmark<StatefulSPEventLoopThread<int&, std::vector<int>, const double&>>(
+      harness,
+      "StatefulSPEventLoop",
+      false,
+      parameterTask,
+      capture,
+      capture2,
+      capture3);
 #ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoopPool:                   "
-              << sampleDuration(numSamples, atomicTask, evppEventLoopPool1)
-              << "\n";
+    benchmark<evpp::EventLoopThreadPool>(
+      harness, "EVPP EventLoopPool", true, capturing);
 #endif
-    std::cout << "\tEventLoopPool:                        "
-              << sampleDuration(numSamples, atomicTask, eventLoopPool) << "\n";
-    std::cout << "\tStatelessEventLoopPool:               "
-              << sampleDuration(numSamples, atomicTask, statelessEventLoopPool)
-              << "\n";
-    std::cout << "\tSPEventLoopPool:                      "
-              << sampleDuration(numSamples, atomicTask, spEventLoopPool)
-              << "\n";
-    std::cout << "\tStatelessSPEventLoopPool:             "
-              << sampleDuration(
-                   numSamples, atomicTask, spStatelessEventLoopPool)
-              << "\n";
-
-    std::cout << "\n\n";
-
-    std::cout << "Capturing (" << numSamples << " samples):\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoop:                       "
-              << sampleDuration(numSamples, capturingLambda, evppEventLoop2)
-              << "\n";
-#endif
-    std::cout << "\tEventLoop:                            "
-              << sampleDuration(numSamples, capturingLambda, eventLoop) << "\n";
-    std::cout << "\tStatefulEventLoop:                    "
-              << sampleDuration(numSamples, parameterLambda, statefulEventLoop)
-              << "\n";
-    std::cout << "\tSPEventLoop:                          "
-              << sampleDuration(numSamples, capturingLambda, spEventLoop)
-              << "\n";
-    std::cout << "\tStatefulSPEventLoop:                  "
-              << sampleDuration(
-                   numSamples, parameterLambda, spStatefulEventLoop)
-              << "\n";
-    std::cout << "\n";
-#ifdef LINK_EVPP
-    std::cout << "\tEVPP EventLoopPool:                   "
-              << sampleDuration(
-                   numSamples, atomicCapturingLambda, evppEventLoopPool2)
-              << "\n";
-#endif
-    std::cout << "\tEventLoopPool:                        "
-              << sampleDuration(
-                   numSamples, atomicCapturingLambda, eventLoopPool)
-              << "\n";
-    std::cout << "\tStatefulEventLoopPool:                "
-              << sampleDuration(
-                   numSamples, atomicParameterLambda, statefulEventLoopPool)
-              << "\n";
-    std::cout << "\tSPEventLoopPool:                      "
-              << sampleDuration(
-                   numSamples, atomicCapturingLambda, spEventLoopPool)
-              << "\n";
-    std::cout << "\tStatefulSPEventLoopPool:              "
-              << sampleDuration(
-                   numSamples, atomicParameterLambda, spStatefulEventLoopPool)
-              << "\n";
-
+    benchmark<EventLoopThreadPool>(harness, "EventLoopPool", true, capturing);
+    benchmark<SPEventLoopThreadPool>(
+      harness, "SPEventLoopPool", true, capturing);
+    benchmark<SharedQueueEventLoopThreadPool>(
+      harness, "SharedQueueEventLoopPool", true, capturing);
+    benchmark<InplaceEventLoopThreadPool<kMaxTaskSize>>(
+      harness, "InplaceEventLoopPool", true, capturing);
+    benchmark<
+      StatefulEventLoopThreadPool<int&, std::vector<int>, const double&>>(
+      harness,
+      "StatefulEventLoopPool",
+      false,
+      parameterTask,
+      capture,
+      capture2,
+      capture3);
+    benchmark<
+      StatefulSPEventLoopThreadPool<int&, std::vector<int>, const double&>>(
+      harness,
+      "StatefulSPEventLoopPool",
+      false,
+      parameterTask,
+      capture,
+      capture2,
+      capture3);
     return 0;
 }
@@ -0,0 +1,71 @@
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+#include <mcga/threading.hpp>
+
+#define MCGA_BENCHMARK_COUNT_ALLOCATIONS
+#include "benchmark_utils.hpp"
+
+using mcga::threading::EventLoopThread;
+
+// Submits one request at a time and waits for its response, so the duration
+// is the round-trip latency: enqueueing, waking the loop up, and waking the
+// requester back up.
+template<class RoundTrip>
+void printRoundTrips(const char* name,
+                     int numSamples,
+                     const RoundTrip& roundTrip) {
+    DurationTracker tracker;
+    auto allocationsBefore = numAllocations.load();
+    for (int i = 0; i < numSamples; ++i) {
+        Stopwatch watch;
+        if (roundTrip(i) != i + 1) {
+            std::cout << "Wrong result!\n";
+        }
+        tracker.addSample(watch.get());
+    }
+    auto allocations = numAllocations.load() - allocationsBefore;
+    std::cout << "\t" << name << ":\n";
+    std::cout << "\t\t50%: " << tracker.percent(50) << "\n";
+    std::cout << "\t\t99%: " << tracker.percent(99) << "\n";
+    std::cout << "\t\tallocations / request: " << std::fixed
+              << std::setprecision(3)
+              << static_cast<double>(allocations) / numSamples << "\n";
+}
+
+int main(int argc, char** argv) {
+    constexpr int kNumSamplesDefault = 100000;
+    int numSamples = kNumSamplesDefault;
+    if (argc > 1) {
+        numSamples = std::stoi(argv[1]);
+    }
+
+    EventLoopThread loop;
+    loop.start();
+
+    std::cout << "Request / response round trips (" << numSamples
+              << " samples):\n";
+    printRoundTrips("std::promise in std::function", numSamples, [&](int i) {
+        auto promise = std::make_shared<std::promise<int>>();
+        auto future = promise->get_future();
+        loop.enqueue([promise, i] {
+            promise->set_value(i + 1);
+        });
+        return future.get();
+    });
+    printRoundTrips("submit", numSamples, [&](int i) {
+        return loop
+          .submit([i] {
+              return i + 1;
+          })
+          .get();
+    });
+
+    loop.stop();
+    return 0;
+}
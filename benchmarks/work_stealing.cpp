@@ -0,0 +1,76 @@
+#include <iostream>
+#include <vector>
+
+#include <mcga/threading.hpp>
+
+#include "benchmark_utils.hpp"
+
+using mcga::threading::EventLoopThreadPool;
+using mcga::threading::WorkStealingEventLoopThreadPool;
+
+void spinFor(std::chrono::nanoseconds duration) {
+    Stopwatch watch;
+    while (watch.get() < duration) {
+    }
+}
+
+// Every numThreads-th task is expensive, so round robin sends all of them to
+// the same worker and the cheap tasks queued behind them wait.
+template<class Pool>
+DurationTracker sampleQueueingDelays(int numTasks, std::size_t numThreads) {
+    constexpr auto kCheapTaskCost = std::chrono::microseconds{1};
+    constexpr auto kExpensiveTaskCost = std::chrono::microseconds{200};
+
+    std::vector<std::chrono::nanoseconds> delays(numTasks);
+    std::atomic_int tasksExecuted = 0;
+
+    Pool pool{typename Pool::NumThreads(numThreads)};
+    pool.start();
+    for (int i = 0; i < numTasks; ++i) {
+        auto cost = (static_cast<std::size_t>(i) % numThreads == 0)
+          ? kExpensiveTaskCost
+          : kCheapTaskCost;
+        pool.enqueue([&delays, &tasksExecuted, i, cost, watch = Stopwatch()] {
+            delays[i] = watch.get();
+            spinFor(cost);
+            tasksExecuted += 1;
+        });
+    }
+    while (tasksExecuted != numTasks) {
+        std::this_thread::yield();
+    }
+    pool.stop();
+
+    DurationTracker tracker;
+    for (const auto& delay: delays) {
+        tracker.addSample(delay);
+    }
+    return tracker;
+}
+
+void printQueueingDelays(const DurationTracker& tracker) {
+    std::cout << "\t\t50%: " << tracker.percent(50) << "\n";
+    std::cout << "\t\t90%: " << tracker.percent(90) << "\n";
+    std::cout << "\t\t99%: " << tracker.percent(99) << "\n";
+    std::cout << "\t\tmax: " << tracker.max() << "\n";
+}
+
+int main(int argc, char** argv) {
+    constexpr int kNumTasksDefault = 20000;
+    int numTasks = kNumTasksDefault;
+    if (argc > 1) {
+        numTasks = std::stoi(argv[1]);
+    }
+    const std::size_t numThreads
+      = std::max(2U, std::thread::hardware_concurrency());
+
+    std::cout << "Skewed task costs, queueing delay (" << numTasks
+              << " tasks, " << numThreads << " threads):\n";
+    std::cout << "\tEventLoopThreadPool:\n";
+    printQueueingDelays(
+      sampleQueueingDelays<EventLoopThreadPool>(numTasks, numThreads));
+    std::cout << "\tWorkStealingEventLoopThreadPool:\n";
+    printQueueingDelays(sampleQueueingDelays<WorkStealingEventLoopThreadPool>(
+      numTasks, numThreads));
+    return 0;
+}
@@ -6,6 +6,9 @@
 // Processors
 #include <mcga/threading/processors/dispatcher_processor.hpp>
 #include <mcga/threading/processors/function_processor.hpp>
+#include <mcga/threading/processors/inplace_function_processor.hpp>
+#include <mcga/threading/processors/latency_tracking_processor.hpp>
+#include <mcga/threading/processors/object_batch_processor.hpp>
 #include <mcga/threading/processors/object_processor.hpp>
 #include <mcga/threading/processors/stateful_function_processor.hpp>
 #include <mcga/threading/processors/stateless_function_processor.hpp>
@@ -23,7 +26,21 @@
     MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
       T_DEF, PROCESSOR, PREFIX, SPEventLoopThread);                            \
     MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
-      T_DEF, PROCESSOR, PREFIX, SPEventLoopThreadPool);
+      T_DEF, PROCESSOR, PREFIX, SPEventLoopThreadPool);                        \
+    MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
+      T_DEF, PROCESSOR, PREFIX, MPSCEventLoopThread);                          \
+    MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
+      T_DEF, PROCESSOR, PREFIX, MPSCEventLoopThreadPool);                      \
+    MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
+      T_DEF, PROCESSOR, PREFIX, WorkStealingEventLoopThreadPool);              \
+    MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
+      T_DEF, PROCESSOR, PREFIX, SharedQueueEventLoopThreadPool);               \
+    MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
+      T_DEF, PROCESSOR, PREFIX, LoadBalancedEventLoopThreadPool);              \
+    MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
+      T_DEF, PROCESSOR, PREFIX, ConsistentHashEventLoopThreadPool);            \
+    MCGA_THREADING_DEFINE_CONSTRUCT_INTERNAL(                                  \
+      T_DEF, PROCESSOR, PREFIX, ElasticEventLoopThreadPool);
 
 #define MCGA_THREADING_DEFINE_CONSTRUCTS(PROCESSOR, PREFIX)                    \
     MCGA_THREADING_DEFINE_CONSTRUCTS_INTERNAL(, PROCESSOR, PREFIX);
@@ -34,10 +51,33 @@
 
 namespace mcga::threading {
 
+using base::BlockOnOverflow;
+using base::CoTask;
+using base::Deadline;
+using base::DropNewestOnOverflow;
+using base::DropOldestOnOverflow;
+using base::ElasticPoolOptions;
+using base::FailOnOverflow;
+using base::Future;
+using base::IntervalMode;
+using base::LatencyHistogram;
+using base::LatencyReport;
+using base::LatencyStats;
+using base::LoopStats;
+using base::Priority;
+using base::RunLateTasks;
+using base::ShedLateTasks;
+using base::syncWait;
+using base::ThreadPlacement;
+using base::TimerOptions;
+
 MCGA_THREADING_DEFINE_CONSTRUCTS(processors::FunctionProcessor, );
 
 MCGA_THREADING_DEFINE_TEMPLATE_CONSTRUCTS(processors::ObjectProcessor, Object);
 
+MCGA_THREADING_DEFINE_TEMPLATE_CONSTRUCTS(processors::ObjectBatchProcessor,
+                                          ObjectBatch);
+
 MCGA_THREADING_DEFINE_TEMPLATE_CONSTRUCTS(processors::StatefulFunctionProcessor,
                                           Stateful);
 
@@ -47,4 +87,87 @@ MCGA_THREADING_DEFINE_CONSTRUCTS(processors::StatelessFunctionProcessor,
 MCGA_THREADING_DEFINE_TEMPLATE_CONSTRUCTS(processors::DispatcherProcessor,
                                           Dispatcher);
 
+// Function constructs holding at most Capacity immediate tasks per worker,
+// e.g. BoundedEventLoopThreadPool<4096, DropOldestOnOverflow>.
+template<std::size_t Capacity, class Overflow = BlockOnOverflow>
+using BoundedEventLoopThread
+  = constructs::BoundedEventLoopThreadConstruct<processors::FunctionProcessor,
+                                                Capacity,
+                                                Overflow>;
+
+template<std::size_t Capacity, class Overflow = BlockOnOverflow>
+using BoundedSPEventLoopThread = constructs::
+  BoundedSPEventLoopThreadConstruct<processors::FunctionProcessor,
+                                    Capacity,
+                                    Overflow>;
+
+template<std::size_t Capacity, class Overflow = BlockOnOverflow>
+using BoundedEventLoopThreadPool = constructs::
+  BoundedEventLoopThreadPoolConstruct<processors::FunctionProcessor,
+                                      Capacity,
+                                      Overflow>;
+
+template<std::size_t Capacity, class Overflow = BlockOnOverflow>
+using BoundedSPEventLoopThreadPool = constructs::
+  BoundedSPEventLoopThreadPoolConstruct<processors::FunctionProcessor,
+                                        Capacity,
+                                        Overflow>;
+
+// Function constructs whose workers keep LoopMetrics, see stats().
+using MeteredEventLoopThread = constructs::MeteredEventLoopThreadConstruct<
+  processors::FunctionProcessor>;
+
+using MeteredEventLoopThreadPool = constructs::
+  MeteredEventLoopThreadPoolConstruct<processors::FunctionProcessor>;
+
+// Function constructs recording the queueing delay and execution time of one
+// in every SampleEvery tasks, see latencies().
+template<std::size_t SampleEvery = processors::kDefaultLatencySampleEvery>
+using LatencyTrackedEventLoopThread
+  = constructs::LatencyTrackedEventLoopThreadConstruct<
+    processors::LatencyTrackingProcessor<processors::FunctionProcessor,
+                                         SampleEvery>>;
+
+template<std::size_t SampleEvery = processors::kDefaultLatencySampleEvery>
+using LatencyTrackedEventLoopThreadPool
+  = constructs::LatencyTrackedEventLoopThreadPoolConstruct<
+    processors::LatencyTrackingProcessor<processors::FunctionProcessor,
+                                         SampleEvery>>;
+
+// Function constructs with NumLanes immediate lanes, drained by priority,
+// e.g. PriorityEventLoopThread<3> and loop.enqueue(task, Priority(2)).
+template<std::size_t NumLanes = 2,
+         std::size_t DrainRatio = base::kDefaultDrainRatio>
+using PriorityEventLoopThread = constructs::
+  PriorityEventLoopThreadConstruct<processors::FunctionProcessor,
+                                   NumLanes,
+                                   DrainRatio>;
+
+template<std::size_t NumLanes = 2,
+         std::size_t DrainRatio = base::kDefaultDrainRatio>
+using PriorityEventLoopThreadPool = constructs::
+  PriorityEventLoopThreadPoolConstruct<processors::FunctionProcessor,
+                                       NumLanes,
+                                       DrainRatio>;
+
+// Function constructs executing their immediate tasks earliest deadline
+// first, e.g. loop.enqueue(task, Deadline::clock::now() + 5ms). Late tasks
+// are shed, or executed anyway with RunLateTasks. Tasks without a deadline,
+// from enqueue(task), submit() or schedule(), only run when no task with one
+// is waiting.
+template<class Late = ShedLateTasks>
+using DeadlineEventLoopThread = constructs::
+  DeadlineEventLoopThreadConstruct<processors::FunctionProcessor, Late>;
+
+template<class Late = ShedLateTasks>
+using DeadlineEventLoopThreadPool = constructs::
+  DeadlineEventLoopThreadPoolConstruct<processors::FunctionProcessor, Late>;
+
+// Move-only tasks stored inline, e.g. InplaceEventLoopThread<> or
+// InplaceEventLoopThreadPool<128> for callables of up to 128 bytes.
+MCGA_THREADING_DEFINE_CONSTRUCTS_INTERNAL(
+  template<std::size_t Capacity = processors::kDefaultInplaceFunctionCapacity>,
+  processors::InplaceFunctionProcessor<Capacity>,
+  Inplace);
+
 }  // namespace mcga::threading
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+
+namespace mcga::threading::base {
+
+// Overflow policies of BoundedImmediateQueueWrapper, deciding what enqueue()
+// does with a task when the queue is full.
+
+// Blocks the producer until the loop makes room for the task. Tasks must then
+// not enqueue into their own loop, which would wait for itself when full.
+struct BlockOnOverflow {};
+
+// Rejects the task. Use tryEnqueue() to find out whether a task was rejected.
+struct FailOnOverflow {};
+
+// Drops the oldest task in the queue to make room for the new one. With
+// multiple producers, this is the oldest task of one of them, not necessarily
+// the oldest task overall.
+struct DropOldestOnOverflow {};
+
+// Drops the new task, keeping the tasks already in the queue.
+struct DropNewestOnOverflow {};
+
+// Immediate queue that holds at most Capacity tasks, on top of an unbounded
+// Queue (ImmediateQueueWrapper or SPImmediateQueueWrapper), so that producers
+// outpacing the loop cannot grow its memory without limit.
+//
+// Capacity bounds the tasks that are queued and not yet dequeued: a task
+// gives its slot back when the loop takes it off the queue, before executing
+// it, so the loop can hold up to one more batch of dequeued tasks on top of
+// Capacity queued ones. Releasing slots only after execution would let
+// DropOldestOnOverflow find the queue full and empty at the same time, with
+// nothing to drop. Whatever the overflow policy, tryEnqueue()
+// never blocks and never drops a task, and tryEnqueueFor() blocks for at most
+// the given timeout. Rejected tasks are the ones turned away by enqueue()
+// with FailOnOverflow or by a failed tryEnqueue() or tryEnqueueFor(), dropped
+// tasks the ones discarded by the drop policies.
+template<class Queue, std::size_t Capacity, class Overflow = BlockOnOverflow>
+class BoundedImmediateQueueWrapper : public Queue {
+    static_assert(Capacity > 0, "A bounded queue needs at least one slot.");
+
+  public:
+    using Task = typename Queue::Task;
+
+    // Returns whether the task went into the queue, rather than being
+    // rejected or dropped by the overflow policy.
+    bool enqueue(Task task) {
+        if (tryReserve(1) == 1) {
+            Queue::enqueue(std::move(task));
+            return true;
+        }
+        if constexpr (std::is_same_v<Overflow, BlockOnOverflow>) {
+            waitForSlot([this](std::unique_lock<std::mutex>& lock) {
+                slotFreed.wait(lock);
+                return true;
+            });
+            Queue::enqueue(std::move(task));
+            return true;
+        } else if constexpr (std::is_same_v<Overflow, FailOnOverflow>) {
+            numRejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else if constexpr (std::is_same_v<Overflow, DropOldestOnOverflow>) {
+            enqueueDroppingOldest(std::move(task));
+            return true;
+        } else {
+            static_assert(std::is_same_v<Overflow, DropNewestOnOverflow>,
+                          "Unknown overflow policy.");
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    // Enqueues the tasks that fit in one bulk enqueue, and the rest one by
+    // one, following the overflow policy. Returns how many went into the
+    // queue.
+    template<class It>
+    std::size_t enqueueBulk(It first, std::size_t count) {
+        auto numEnqueued = tryReserve(count);
+        Queue::enqueueBulk(first, numEnqueued);
+        std::advance(first, numEnqueued);
+        for (std::size_t i = numEnqueued; i < count; ++i, ++first) {
+            numEnqueued += enqueue(std::move(*first)) ? 1 : 0;
+        }
+        return numEnqueued;
+    }
+
+    // Only moves from the task if it was enqueued.
+    bool tryEnqueue(Task&& task) {
+        if (tryReserve(1) == 1) {
+            Queue::enqueue(std::move(task));
+            return true;
+        }
+        numRejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Only moves from the task if it was enqueued.
+    template<class Rep, class Ratio>
+    bool tryEnqueueFor(Task&& task,
+                       const std::chrono::duration<Rep, Ratio>& timeout) {
+        if (tryReserve(1) == 1) {
+            Queue::enqueue(std::move(task));
+            return true;
+        }
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        bool reserved = waitForSlot(
+          [this, deadline](std::unique_lock<std::mutex>& lock) {
+              return slotFreed.wait_until(lock, deadline)
+                != std::cv_status::timeout;
+          });
+        if (!reserved) {
+            numRejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Queue::enqueue(std::move(task));
+        return true;
+    }
+
+    std::size_t numRejectedTasks() const {
+        return numRejected.load(std::memory_order_relaxed);
+    }
+
+    std::size_t numDroppedTasks() const {
+        return numDropped.load(std::memory_order_relaxed);
+    }
+
+  protected:
+    template<class Processor>
+    bool executeImmediate(Processor* processor) {
+        return executeImmediate(processor, [](std::size_t /*numDequeued*/) {});
+    }
+
+    template<class Processor, class OnDequeued>
+    bool executeImmediate(Processor* processor, const OnDequeued& onDequeued) {
+        return Queue::executeImmediate(
+          processor, [this, &onDequeued](std::size_t numDequeued) {
+              release(numDequeued);
+              onDequeued(numDequeued);
+          });
+    }
+
+  private:
+    // Takes up to count free slots, and returns how many it took.
+    std::size_t tryReserve(std::size_t count) {
+        auto size = numSlotsTaken.load();
+        while (size < Capacity) {
+            auto numReserved = std::min(count, Capacity - size);
+            if (numSlotsTaken.compare_exchange_weak(size, size + numReserved)) {
+                return numReserved;
+            }
+        }
+        return 0;
+    }
+
+    void release(std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+        numSlotsTaken.fetch_sub(count);
+        // Pairs with the increment in waitForSlot(): either the producer sees
+        // the slots we just freed, or we see it waiting.
+        if (numBlockedProducers.load() > 0) {
+            // A blocked producer only releases the lock while waiting, so it
+            // cannot miss the notification.
+            std::lock_guard guard(slotLock);
+            slotFreed.notify_all();
+        }
+    }
+
+    // Waits for a slot until wait() returns false, and returns whether a slot
+    // was taken.
+    template<class Wait>
+    bool waitForSlot(const Wait& wait) {
+        std::unique_lock lock(slotLock);
+        numBlockedProducers.fetch_add(1);
+        bool reserved = (tryReserve(1) == 1);
+        while (!reserved && wait(lock)) {
+            reserved = (tryReserve(1) == 1);
+        }
+        numBlockedProducers.fetch_sub(1);
+        return reserved || tryReserve(1) == 1;
+    }
+
+    void enqueueDroppingOldest(Task task) {
+        Task oldest;
+        while (tryReserve(1) == 0) {
+            // The slot of the dropped task goes to the new one. If the loop
+            // emptied the queue in the meantime, there are free slots again.
+            if (Queue::tryDequeue(oldest)) {
+                numDropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        Queue::enqueue(std::move(task));
+    }
+
+    std::atomic_size_t numSlotsTaken = 0;
+    std::atomic_size_t numBlockedProducers = 0;
+    std::atomic_size_t numRejected = 0;
+    std::atomic_size_t numDropped = 0;
+    std::mutex slotLock;
+    std::condition_variable slotFreed;
+};
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mcga::threading::base {
+
+// The task enqueued to resume a coroutine on a loop. Only holds the handle,
+// so it fits in the small buffer of std::function and needs no allocation.
+class CoroutineResumer {
+  public:
+    explicit CoroutineResumer(std::coroutine_handle<> handle): handle(handle) {
+    }
+
+    void operator()() const {
+        handle.resume();
+    }
+
+  private:
+    std::coroutine_handle<> handle;
+};
+
+// co_await loop.schedule() resumes the awaiting coroutine on loop.
+template<class Loop>
+class ScheduleAwaitable {
+  public:
+    explicit ScheduleAwaitable(Loop* loop): loop(loop) {
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        loop->enqueue(CoroutineResumer(handle));
+    }
+
+    void await_resume() const noexcept {
+    }
+
+  private:
+    Loop* loop;
+};
+
+// co_await loop.sleepFor(delay) resumes the awaiting coroutine on loop, once
+// delay has passed.
+template<class Loop, class Delay>
+class SleepAwaitable {
+  public:
+    SleepAwaitable(Loop* loop, Delay delay): loop(loop), delay(delay) {
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        loop->enqueueDelayed(CoroutineResumer(handle), delay);
+    }
+
+    void await_resume() const noexcept {
+    }
+
+  private:
+    Loop* loop;
+    Delay delay;
+};
+
+template<class T>
+class CoTask;
+
+template<class T>
+class CoTaskPromise {
+    using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+  public:
+    CoTask<T> get_return_object() noexcept;
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    // Resumes whoever awaited the task, through symmetric transfer, so that
+    // long chains of tasks do not grow the stack.
+    class FinalAwaitable {
+      public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template<class Promise>
+        std::coroutine_handle<>
+          await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+            return handle.promise().continuation;
+        }
+
+        void await_resume() const noexcept {
+        }
+    };
+
+    FinalAwaitable final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() noexcept {
+        result.template emplace<2>(std::current_exception());
+    }
+
+    // Rethrows the exception the coroutine exited with, if any.
+    T takeResult() {
+        if (result.index() == 2) {
+            std::rethrow_exception(std::get<2>(result));
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(std::get<1>(result));
+        }
+    }
+
+    void setContinuation(std::coroutine_handle<> handle) {
+        continuation = handle;
+    }
+
+  protected:
+    template<class... Args>
+    void setValue(Args&&... args) {
+        result.template emplace<1>(std::forward<Args>(args)...);
+    }
+
+  private:
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::variant<std::monostate, Value, std::exception_ptr> result;
+};
+
+// A void coroutine needs return_void() instead of return_value(), and a
+// promise cannot declare both.
+template<class T>
+class CoTaskPromiseType : public CoTaskPromise<T> {
+  public:
+    template<class U = T>
+    void return_value(U&& value) {
+        this->setValue(std::forward<U>(value));
+    }
+};
+
+template<>
+class CoTaskPromiseType<void> : public CoTaskPromise<void> {
+  public:
+    void return_void() {
+        this->setValue();
+    }
+};
+
+// A lazily started coroutine returning a T. It starts running when awaited,
+// on the thread of the awaiting coroutine, and resumes it when done, on
+// whichever loop it finished on. Use syncWait() to run one from outside of a
+// coroutine.
+template<class T = void>
+class CoTask {
+  public:
+    using promise_type = CoTaskPromiseType<T>;
+
+    explicit CoTask(std::coroutine_handle<promise_type> handle)
+            : handle(handle) {
+    }
+
+    CoTask(const CoTask&) = delete;
+
+    CoTask(CoTask&& other) noexcept
+            : handle(std::exchange(other.handle, nullptr)) {
+    }
+
+    CoTask& operator=(const CoTask&) = delete;
+
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~CoTask() {
+        destroy();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaitable {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<>
+              await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().setContinuation(awaiting);
+                return handle;
+            }
+
+            T await_resume() {
+                return handle.promise().takeResult();
+            }
+
+            std::coroutine_handle<promise_type> handle;
+        };
+        return Awaitable{handle};
+    }
+
+  private:
+    void destroy() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template<class T>
+CoTask<T> CoTaskPromise<T>::get_return_object() noexcept {
+    return CoTask<T>(std::coroutine_handle<CoTaskPromiseType<T>>::from_promise(
+      static_cast<CoTaskPromiseType<T>&>(*this)));
+}
+
+// Coroutine that syncWait() blocks on. Signals the waiting thread only once
+// suspended for good, so the waiter can safely destroy it.
+class SyncWaitCoroutine {
+  public:
+    struct promise_type {
+        std::mutex lock;
+        std::condition_variable condition;
+        bool done = false;
+
+        SyncWaitCoroutine get_return_object() noexcept {
+            return SyncWaitCoroutine(
+              std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() const noexcept {
+            return {};
+        }
+
+        auto final_suspend() const noexcept {
+            struct FinalAwaitable {
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(
+                  std::coroutine_handle<promise_type> handle) const noexcept {
+                    promise_type& promise = handle.promise();
+                    std::lock_guard guard(promise.lock);
+                    promise.done = true;
+                    promise.condition.notify_one();
+                }
+
+                void await_resume() const noexcept {
+                }
+            };
+            return FinalAwaitable{};
+        }
+
+        void return_void() const noexcept {
+        }
+
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+
+    explicit SyncWaitCoroutine(std::coroutine_handle<promise_type> handle)
+            : handle(handle) {
+    }
+
+    SyncWaitCoroutine(const SyncWaitCoroutine&) = delete;
+    SyncWaitCoroutine& operator=(const SyncWaitCoroutine&) = delete;
+
+    ~SyncWaitCoroutine() {
+        handle.destroy();
+    }
+
+    void run() {
+        handle.resume();
+        promise_type& promise = handle.promise();
+        std::unique_lock lock(promise.lock);
+        promise.condition.wait(lock, [&promise] {
+            return promise.done;
+        });
+    }
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Runs task to completion, blocking the calling thread, and returns its
+// result or rethrows its exception.
+template<class T>
+T syncWait(CoTask<T> task) {
+    using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+    std::variant<std::monostate, Value, std::exception_ptr> result;
+    auto run = [](CoTask<T> task,
+                  decltype(result)& result) -> SyncWaitCoroutine {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(task);
+            } else {
+                result.template emplace<1>(co_await std::move(task));
+            }
+        } catch (...) {
+            result.template emplace<2>(std::current_exception());
+        }
+    };
+    run(std::move(task), result).run();
+    if (result.index() == 2) {
+        std::rethrow_exception(std::get<2>(result));
+    }
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(std::get<1>(result));
+    }
+}
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <concurrentqueue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace mcga::threading::base {
+
+using Deadline = std::chrono::steady_clock::time_point;
+
+// Late policies of DeadlineImmediateQueueWrapper, deciding what the loop does
+// with a task whose deadline passed before it got to execute it.
+
+// Executes it anyway, in deadline order.
+struct RunLateTasks {};
+
+// Does not execute it. If a late task callback is set, the task is handed to
+// it instead, on the loop thread.
+struct ShedLateTasks {};
+
+// Immediate queue that executes its tasks earliest deadline first, instead of
+// in the order they were enqueued. Tasks with the same deadline run in the
+// order the loop received them.
+//
+// Tasks enqueued without a deadline, including the ones of submit() and
+// schedule(), only run when no task with a deadline is waiting, so they
+// starve for as long as deadline tasks keep coming. Give them a distant
+// deadline instead to bound how long they can wait.
+//
+// Producers push to a queue, which the loop drains into a heap it owns, like
+// DelayedQueueWrapper does for timers, so one loop can mix timers and
+// deadline-ordered work. Every iteration executes at most MaxBatchSize tasks,
+// so newly enqueued tasks with an earlier deadline are not kept waiting for
+// long behind a large backlog. Whether a task is late is decided against the
+// time the iteration started.
+template<class Processor,
+         class Late = ShedLateTasks,
+         std::size_t MaxBatchSize = 64>
+class DeadlineImmediateQueueWrapper {
+    static_assert(std::is_same_v<Late, RunLateTasks>
+                    || std::is_same_v<Late, ShedLateTasks>,
+                  "Unknown late policy.");
+
+    static constexpr std::size_t kDrainBatchSize = 64;
+
+  public:
+    using Task = typename Processor::Task;
+    using LateTaskCallback = std::function<void(Task&, Deadline)>;
+
+    void enqueue(Task task) {
+        enqueue(std::move(task), Deadline::max());
+    }
+
+    void enqueue(Task task, Deadline deadline) {
+        numPending.fetch_add(1, std::memory_order_relaxed);
+        inbox.enqueue(Entry{deadline, 0, std::move(task)});
+    }
+
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i, ++first) {
+            enqueue(std::move(*first));
+        }
+    }
+
+    // Only used by ShedLateTasks. Must be set before the loop is started.
+    void setLateTaskCallback(LateTaskCallback callback) {
+        lateTaskCallback = std::move(callback);
+    }
+
+    // The number of tasks that were late when the loop got to them, whether
+    // they were executed or shed.
+    std::size_t numLateTasks() const {
+        return numLate.load(std::memory_order_relaxed);
+    }
+
+  protected:
+    std::size_t getImmediateQueueSize() const {
+        return numPending.load(std::memory_order_relaxed);
+    }
+
+    bool executeImmediate(Processor* processor) {
+        return executeImmediate(processor, [](std::size_t /*numDequeued*/) {});
+    }
+
+    // Calls onDequeued() with the number of tasks the iteration will take off
+    // the heap, before executing them.
+    template<class OnDequeued>
+    bool executeImmediate(Processor* processor, const OnDequeued& onDequeued) {
+        drainInbox();
+        if (heap.empty()) {
+            return false;
+        }
+        auto batchSize = std::min(heap.size(), MaxBatchSize);
+        onDequeued(batchSize);
+        // If even the earliest task has no deadline, none of them can be
+        // late, and the clock is not read at all.
+        const Deadline now = heap.front().deadline == Deadline::max()
+          ? Deadline::min()
+          : Deadline::clock::now();
+        for (std::size_t i = 0; i < batchSize; ++i) {
+            std::pop_heap(heap.begin(), heap.end(), Compare());
+            Entry entry = std::move(heap.back());
+            heap.pop_back();
+            execute(processor, entry, now);
+            numPending.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+  private:
+    struct Entry {
+        Deadline deadline;
+        // Breaks ties between equal deadlines, in the order the loop
+        // received the tasks.
+        std::uint64_t sequence;
+        Task task;
+    };
+
+    struct Compare {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.deadline != b.deadline) {
+                return a.deadline > b.deadline;
+            }
+            return a.sequence > b.sequence;
+        }
+    };
+
+    // Moves the entries straight from the queue to the back of the heap, so
+    // there is no staging buffer of default-constructed entries.
+    void drainInbox() {
+        if (inbox.size_approx() == 0) {
+            return;
+        }
+        auto numHeaped = heap.size();
+        std::size_t numDequeued;
+        do {
+            numDequeued = inbox.try_dequeue_bulk(
+              inboxToken, std::back_inserter(heap), kDrainBatchSize);
+        } while (numDequeued == kDrainBatchSize);
+        for (; numHeaped < heap.size(); ++numHeaped) {
+            heap[numHeaped].sequence = nextSequence++;
+            std::push_heap(heap.begin(), heap.begin() + numHeaped + 1,
+                           Compare());
+        }
+    }
+
+    void execute(Processor* processor, Entry& entry, const Deadline& now) {
+        if (entry.deadline >= now) {
+            processor->executeTask(entry.task);
+            return;
+        }
+        numLate.fetch_add(1, std::memory_order_relaxed);
+        if constexpr (std::is_same_v<Late, RunLateTasks>) {
+            processor->executeTask(entry.task);
+        } else if (lateTaskCallback) {
+            lateTaskCallback(entry.task, entry.deadline);
+        }
+    }
+
+    moodycamel::ConcurrentQueue<Entry> inbox;
+    moodycamel::ConsumerToken inboxToken{inbox};
+    std::vector<Entry> heap;
+    std::uint64_t nextSequence = 0;
+    std::atomic_size_t numPending = 0;
+    std::atomic_size_t numLate = 0;
+    LateTaskCallback lateTaskCallback;
+};
+
+}  // namespace mcga::threading::base
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <mutex>
+#include <memory>
+#include <vector>
 
 #include "delayed_task.hpp"
+#include "delayed_task_inbox.hpp"
 
 namespace mcga::threading::base {
 
@@ -15,67 +18,153 @@ class DelayedQueueWrapper {
 
   private:
     using DelayedTask = ::mcga::threading::base::DelayedTask<Task>;
-    using Clock = typename DelayedTask::Clock;
 
   public:
+    using Clock = typename DelayedTask::Clock;
     using DelayedTaskPtr = typename DelayedTask::DelayedTaskPtr;
     using Delay = std::chrono::nanoseconds;
 
-    DelayedTaskPtr enqueueDelayed(Task task, const Delay& delay) {
-        return enqueueDelayedTask(DelayedTask::delayed(std::move(task), delay));
+    DelayedTaskPtr enqueueDelayed(Task task,
+                                  const Delay& delay,
+                                  const TimerOptions& options = {}) {
+        return enqueueDelayedTask(
+          DelayedTask::delayed(std::move(task), delay, options));
     }
 
-    DelayedTaskPtr enqueueInterval(Task task, const Delay& delay) {
+    DelayedTaskPtr enqueueInterval(Task task,
+                                   const Delay& delay,
+                                   const TimerOptions& options = {}) {
         return enqueueDelayedTask(
-          DelayedTask::interval(std::move(task), delay));
+          DelayedTask::interval(std::move(task), delay, options));
+    }
+
+    // Cancelled tasks the loop did not drop yet.
+    std::size_t numDeadDelayedTasks() const {
+        return numDead->load(std::memory_order_relaxed);
+    }
+
+    std::size_t numLiveDelayedTasks() const {
+        auto size = getDelayedQueueSize();
+        auto dead = numDeadDelayedTasks();
+        return size > dead ? size - dead : 0;
     }
 
   protected:
     DelayedTaskPtr enqueueDelayedTask(DelayedTaskPtr delayedTask) {
-        std::lock_guard guard(queueLock);
-        queue.push(delayedTask);
+        delayedTask->numDead = numDead;
+        numDelayedTasks.fetch_add(1, std::memory_order_relaxed);
+        inbox.push(delayedTask);
         return delayedTask;
     }
 
     std::size_t getDelayedQueueSize() const {
-        std::lock_guard guard(queueLock);
-        return queue.size();
+        return numDelayedTasks.load(std::memory_order_relaxed);
     }
 
-    DelayedTaskPtr popDelayedQueue() {
-        std::lock_guard guard(queueLock);
-        if (queue.empty()) {
-            return nullptr;
-        }
-        auto top = queue.top();
-        if (!top->shouldExecute()) {
+    // The methods below must only be called from the loop thread, which owns
+    // the heap. Producers only ever touch the inbox. The loop passes in the
+    // current time, which it does not read on every iteration.
+    //
+    // The heap is ordered by the time point each task may run at the latest,
+    // which is also when the loop wakes up. A task is popped as soon as it is
+    // due though, so a loop that is awake anyway runs the tasks whose slack
+    // did not run out yet.
+
+    typename Clock::time_point getNextDelayedTimePoint() {
+        drainInbox();
+        return nextTimePoint;
+    }
+
+    DelayedTaskPtr popDelayedQueue(const typename Clock::time_point& now) {
+        drainInbox();
+        if (queue.empty() || queue.front()->timePoint > now) {
             return nullptr;
         }
-        queue.pop();
+        std::pop_heap(queue.begin(), queue.end(), Compare());
+        auto top = std::move(queue.back());
+        queue.pop_back();
+        updateNextTimePoint();
         return top;
     }
 
-    bool executeDelayed(Processor* processor) {
-        auto delayedTask = this->popDelayedQueue();
+    bool executeDelayed(Processor* processor,
+                        const typename Clock::time_point& now) {
+        return executeDelayed(
+          processor, now, [](const auto& /*dueTimePoint*/, auto& /*task*/) {});
+    }
+
+    // Calls onExecute() with the time point the task was due at and the task,
+    // right before executing it.
+    template<class OnExecute>
+    bool executeDelayed(Processor* processor,
+                        const typename Clock::time_point& now,
+                        const OnExecute& onExecute) {
+        auto delayedTask = this->popDelayedQueue(now);
         if (delayedTask == nullptr) {
             return false;
         }
         if (!delayedTask->isCancelled()) {
+            onExecute(delayedTask->timePoint, delayedTask->task);
             processor->executeTask(delayedTask->task);
         }
         if (!delayedTask->isCancelled() && delayedTask->isInterval()) {
-            delayedTask->setTimePoint();
-            this->enqueueDelayedTask(delayedTask);
+            delayedTask->setNextTimePoint();
+            push(std::move(delayedTask));
+            return true;
+        }
+        if (!delayedTask->finish()) {
+            delayedTask->reclaim();
         }
+        numDelayedTasks.fetch_sub(1, std::memory_order_relaxed);
         return true;
     }
 
   private:
-    mutable std::mutex queueLock;
-    std::priority_queue<DelayedTaskPtr,
-                        std::vector<DelayedTaskPtr>,
-                        typename DelayedTask::Compare>
-      queue;
+    using Compare = typename DelayedTask::Compare;
+
+    void push(DelayedTaskPtr delayedTask) {
+        queue.push_back(std::move(delayedTask));
+        std::push_heap(queue.begin(), queue.end(), Compare());
+        updateNextTimePoint();
+    }
+
+    void drainInbox() {
+        inbox.drain([this](DelayedTaskPtr delayedTask) {
+            push(std::move(delayedTask));
+        });
+        if (shouldCompactDelayedQueue(numDeadDelayedTasks(), queue.size())) {
+            compact();
+        }
+    }
+
+    // Drops all cancelled tasks from the heap at once.
+    void compact() {
+        auto dead = std::partition(
+          queue.begin(), queue.end(), [](const DelayedTaskPtr& delayedTask) {
+              return !delayedTask->isCancelled();
+          });
+        for (auto it = dead; it != queue.end(); ++it) {
+            (*it)->reclaim();
+        }
+        numDelayedTasks.fetch_sub(queue.end() - dead,
+                                  std::memory_order_relaxed);
+        queue.erase(dead, queue.end());
+        std::make_heap(queue.begin(), queue.end(), Compare());
+        updateNextTimePoint();
+    }
+
+    void updateNextTimePoint() {
+        nextTimePoint = queue.empty() ? Clock::time_point::max()
+                                      : queue.front()->latestTimePoint();
+    }
+
+    DelayedTaskInbox<DelayedTaskPtr> inbox;
+    std::atomic_size_t numDelayedTasks = 0;
+    // Shared with the tasks, since users can keep them past the loop.
+    std::shared_ptr<std::atomic_size_t> numDead
+      = std::make_shared<std::atomic_size_t>(0);
+    std::vector<DelayedTaskPtr> queue;
+    typename Clock::time_point nextTimePoint = Clock::time_point::max();
 };
 
 }  // namespace mcga::threading::base
@@ -2,41 +2,92 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 
+#include "timer_options.hpp"
+
 namespace mcga::threading::base {
 
+// Cancelled tasks stay in a delayed queue, dead, until the loop gets to them.
+// So that they do not hold on to their memory until they would have been
+// due, the loop drops all of them at once when they make up more than half of
+// the queue, and there are at least kMinDeadDelayedTasksToCompact of them.
+constexpr std::size_t kMinDeadDelayedTasksToCompact = 64;
+
+inline bool shouldCompactDelayedQueue(std::size_t numDead,
+                                      std::size_t queueSize) {
+    return numDead >= kMinDeadDelayedTasksToCompact && numDead * 2 > queueSize;
+}
+
 template<class Task>
 class DelayedTask {
   public:
     using Delay = std::chrono::nanoseconds;
 
+    // Returns false if this call cancelled the task, true if the task was
+    // already cancelled or has already finished executing.
     bool cancel() {
-        return cancelled.exchange(true);
+        // Counted before the task is flagged, so that the loop never drops
+        // it before it is counted.
+        numDead->fetch_add(1, std::memory_order_relaxed);
+        auto expected = kPending;
+        if (!state.compare_exchange_strong(
+              expected, kCancelled, std::memory_order_acq_rel)) {
+            numDead->fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
     }
 
   private:
+    static constexpr std::uint8_t kPending = 0;
+    static constexpr std::uint8_t kCancelled = 1;
+    static constexpr std::uint8_t kFinished = 2;
+
     using Clock = std::chrono::steady_clock;
     using DelayedTaskPtr = std::shared_ptr<DelayedTask>;
 
+    // Orders a heap by the time point the loop must wake up at.
     struct Compare {
         inline bool operator()(const DelayedTaskPtr& a,
                                const DelayedTaskPtr& b) const {
-            return a->timePoint > b->timePoint;
+            return a->latestTimePoint() > b->latestTimePoint();
         }
     };
 
     class MakeSharedEnabler;
-    static DelayedTaskPtr delayed(Task task, const Delay& delay);
-    static DelayedTaskPtr interval(Task task, const Delay& delay);
-
-    DelayedTask(Task task, const Delay& delay, bool isRepeated)
-            : task(std::move(task)), delay(delay), isRepeated(isRepeated) {
+    static DelayedTaskPtr
+      delayed(Task task, const Delay& delay, const TimerOptions& options);
+    static DelayedTaskPtr
+      interval(Task task, const Delay& delay, const TimerOptions& options);
+
+    DelayedTask(Task task,
+                const Delay& delay,
+                bool isRepeated,
+                const TimerOptions& options)
+            : task(std::move(task)), delay(delay), isRepeated(isRepeated),
+              options(options) {
         setTimePoint();
     }
 
     bool isCancelled() const {
-        return cancelled;
+        return state.load(std::memory_order_acquire) == kCancelled;
+    }
+
+    // Called by the loop once it is done with the task. Returns false if the
+    // task was cancelled in the meantime, and must then be reclaim()ed.
+    bool finish() {
+        auto expected = kPending;
+        return state.compare_exchange_strong(
+          expected, kFinished, std::memory_order_acq_rel);
+    }
+
+    // Called by the loop when it drops a cancelled task. Frees what the task
+    // holds even if a DelayedTaskPtr to it is kept around.
+    void reclaim() {
+        task = Task();
+        numDead->fetch_sub(1, std::memory_order_relaxed);
     }
 
     bool isInterval() const {
@@ -52,34 +103,64 @@ class DelayedTask {
           = Clock::now() + std::chrono::duration_cast<Clock::duration>(delay);
     }
 
+    // Re-arms an interval after a run, according to its IntervalMode.
+    void setNextTimePoint() {
+        timePoint = nextIntervalTimePoint(
+          options.mode, timePoint, delay, Clock::now());
+    }
+
+    // The task is due at timePoint, but may run as late as this.
+    Clock::time_point latestTimePoint() const {
+        return timePoint
+          + std::chrono::duration_cast<Clock::duration>(options.slack);
+    }
+
     Task task;
     Delay delay;
     Clock::time_point timePoint;
     bool isRepeated;
-    std::atomic_bool cancelled = false;
+    TimerOptions options;
+    std::atomic_uint8_t state = kPending;
+    // The dead task counter of the queue the task was enqueued in.
+    std::shared_ptr<std::atomic_size_t> numDead;
 
     template<class Processor>
     friend class DelayedQueueWrapper;
+
+    template<class Processor,
+             class Tick,
+             std::size_t SlotBits,
+             std::size_t NumLevels>
+    friend class TimingWheelDelayedQueueWrapper;
 };
 
 template<class Task>
 class DelayedTask<Task>::MakeSharedEnabler : public DelayedTask<Task> {
   public:
-    MakeSharedEnabler(Task task, const Delay& delay, bool isRepeated)
-            : DelayedTask(std::move(task), delay, isRepeated) {
+    MakeSharedEnabler(Task task,
+                      const Delay& delay,
+                      bool isRepeated,
+                      const TimerOptions& options)
+            : DelayedTask(std::move(task), delay, isRepeated, options) {
     }
 };
 
 template<class Task>
-auto DelayedTask<Task>::delayed(Task task, const Delay& delay)
+auto DelayedTask<Task>::delayed(Task task,
+                                const Delay& delay,
+                                const TimerOptions& options)
   -> DelayedTaskPtr {
-    return std::make_shared<MakeSharedEnabler>(std::move(task), delay, false);
+    return std::make_shared<MakeSharedEnabler>(
+      std::move(task), delay, false, options);
 }
 
 template<class Task>
-auto DelayedTask<Task>::interval(Task task, const Delay& delay)
+auto DelayedTask<Task>::interval(Task task,
+                                 const Delay& delay,
+                                 const TimerOptions& options)
   -> DelayedTaskPtr {
-    return std::make_shared<MakeSharedEnabler>(std::move(task), delay, true);
+    return std::make_shared<MakeSharedEnabler>(
+      std::move(task), delay, true, options);
 }
 
 }  // namespace mcga::threading::base
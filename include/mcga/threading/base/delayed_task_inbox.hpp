@@ -0,0 +1,45 @@
+#pragma once
+
+#include <concurrentqueue.h>
+
+#include <array>
+
+namespace mcga::threading::base {
+
+// Hand-off point between the threads enqueueing delayed tasks and the loop
+// thread that owns the timer structure. Producers never touch the timer
+// structure, so it needs no lock; the loop drains the inbox before looking
+// at it.
+template<class DelayedTaskPtr>
+class DelayedTaskInbox {
+  private:
+    static constexpr std::size_t kDrainBatchSize = 64;
+
+  public:
+    void push(DelayedTaskPtr delayedTask) {
+        queue.enqueue(std::move(delayedTask));
+    }
+
+    // Must only be called from the loop thread.
+    template<class Consumer>
+    void drain(const Consumer& consumer) {
+        if (queue.size_approx() == 0) {
+            return;
+        }
+        std::array<DelayedTaskPtr, kDrainBatchSize> buffer;
+        std::size_t numDequeued;
+        do {
+            numDequeued = queue.try_dequeue_bulk(
+              queueToken, buffer.begin(), kDrainBatchSize);
+            for (std::size_t i = 0; i < numDequeued; ++i) {
+                consumer(std::move(buffer[i]));
+            }
+        } while (numDequeued == kDrainBatchSize);
+    }
+
+  private:
+    moodycamel::ConcurrentQueue<DelayedTaskPtr> queue;
+    moodycamel::ConsumerToken queueToken{queue};
+};
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "timer_options.hpp"
+
+namespace mcga::threading::base {
+
+// Slab of delayed task nodes owned by one event loop. Nodes are handed out to
+// producer threads and given back by the loop thread through a lock-free free
+// list, so in steady state scheduling a timer does not allocate. Memory is
+// only returned to the system when the pool is destroyed.
+//
+// Every node carries a generation, bumped when its one-shot task starts
+// executing and each time the node is released.
+// Handles remember the generation they were created for, so a handle to a
+// task that already finished can never cancel the task now reusing its node.
+template<class Task>
+class DelayedTaskPool {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Delay = std::chrono::nanoseconds;
+
+    class Handle;
+
+    class Node {
+      public:
+        bool isCancelled() const {
+            return (state.load(std::memory_order_acquire) & kCancelledBit)
+              != 0;
+        }
+
+        bool isInterval() const {
+            return isRepeated;
+        }
+
+        void setTimePoint() {
+            timePoint = Clock::now()
+              + std::chrono::duration_cast<Clock::duration>(delay);
+        }
+
+        // Re-arms an interval after a run, according to its IntervalMode.
+        void setNextTimePoint() {
+            timePoint = nextIntervalTimePoint(
+              options.mode, timePoint, delay, Clock::now());
+        }
+
+        // Called by the loop right before executing a one-shot task. Bumps
+        // the generation, so the task can no longer be cancelled while it
+        // runs. Returns false if it was cancelled first.
+        bool finish() {
+            std::uint64_t expected = generation() << 1;
+            return state.compare_exchange_strong(
+              expected, expected + 2, std::memory_order_acq_rel);
+        }
+
+        // The task is due at timePoint, but may run as late as this.
+        Clock::time_point latestTimePoint() const {
+            return timePoint
+              + std::chrono::duration_cast<Clock::duration>(options.slack);
+        }
+
+        Task task;
+        Delay delay{};
+        Clock::time_point timePoint;
+        bool isRepeated = false;
+        TimerOptions options;
+
+      private:
+        static constexpr std::uint64_t kCancelledBit = 1;
+
+        std::uint64_t generation() const {
+            return state.load(std::memory_order_relaxed) >> 1;
+        }
+
+        // generation << 1 | cancelled
+        std::atomic_uint64_t state = 0;
+        std::atomic_uint32_t nextFree = 0;
+        std::uint32_t index = 0;
+
+        friend class DelayedTaskPool;
+        friend class Handle;
+    };
+
+    // Pointer-like, so code written against the shared_ptr based delayed
+    // queues (handle->cancel()) keeps working. Must not be used after the loop
+    // that returned it is destroyed.
+    class Handle {
+      public:
+        Handle() = default;
+
+        // Returns false if this call cancelled the task, true if the task was
+        // already cancelled or has already finished executing.
+        bool cancel() const {
+            if (node == nullptr) {
+                return true;
+            }
+            // Counted before the task is flagged, so that the loop never
+            // releases it before it is counted.
+            pool->numDead.fetch_add(1, std::memory_order_relaxed);
+            std::uint64_t expected = generation << 1;
+            if (!node->state.compare_exchange_strong(
+                  expected, expected | Node::kCancelledBit,
+                  std::memory_order_acq_rel)) {
+                pool->numDead.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+        const Handle* operator->() const {
+            return this;
+        }
+
+      private:
+        Handle(DelayedTaskPool* pool, Node* node, std::uint64_t generation)
+                : pool(pool), node(node), generation(generation) {
+        }
+
+        DelayedTaskPool* pool = nullptr;
+        Node* node = nullptr;
+        std::uint64_t generation = 0;
+
+        friend class DelayedTaskPool;
+    };
+
+    DelayedTaskPool() = default;
+
+    DelayedTaskPool(const DelayedTaskPool&) = delete;
+    DelayedTaskPool(DelayedTaskPool&&) = delete;
+
+    DelayedTaskPool& operator=(const DelayedTaskPool&) = delete;
+    DelayedTaskPool& operator=(DelayedTaskPool&&) = delete;
+
+    ~DelayedTaskPool() {
+        for (std::atomic<Node*>& chunk: chunks) {
+            delete[] chunk.load();
+        }
+    }
+
+    // Can be called from any thread.
+    Node* allocate(Task task,
+                   const Delay& delay,
+                   bool isRepeated,
+                   const TimerOptions& options) {
+        Node* node = popFreeNode();
+        if (node == nullptr) {
+            node = freshNode();
+        }
+        node->task = std::move(task);
+        node->delay = delay;
+        node->isRepeated = isRepeated;
+        node->options = options;
+        node->setTimePoint();
+        return node;
+    }
+
+    // Can be called from any thread, but a node must only be released once.
+    void release(Node* node) {
+        node->task = Task();
+        auto state = node->state.exchange((node->generation() + 1) << 1,
+                                          std::memory_order_acq_rel);
+        if ((state & Node::kCancelledBit) != 0) {
+            numDead.fetch_sub(1, std::memory_order_relaxed);
+        }
+        pushFreeNode(node);
+    }
+
+    Handle handleFor(Node* node) {
+        return Handle(this, node, node->generation());
+    }
+
+    // Nodes that were cancelled, but not released yet.
+    std::size_t numDeadNodes() const {
+        return numDead.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr std::size_t kFirstChunkBits = 6;
+    static constexpr std::size_t kMaxChunks = 26;
+
+    // Chunk c holds indices [(2^c - 1) << kFirstChunkBits,
+    // (2^(c+1) - 1) << kFirstChunkBits), so the pool can grow without ever
+    // moving a node.
+    static std::size_t chunkOf(std::uint32_t index) {
+        return std::bit_width((index >> kFirstChunkBits) + 1) - 1;
+    }
+
+    static std::size_t chunkStart(std::size_t chunk) {
+        return ((std::size_t{1} << chunk) - 1) << kFirstChunkBits;
+    }
+
+    static std::size_t chunkSize(std::size_t chunk) {
+        return std::size_t{1} << (chunk + kFirstChunkBits);
+    }
+
+    Node* nodeAt(std::uint32_t index) const {
+        auto chunk = chunkOf(index);
+        return chunks[chunk].load(std::memory_order_acquire)
+          + (index - chunkStart(chunk));
+    }
+
+    Node* freshNode() {
+        auto index = numFreshNodes.fetch_add(1, std::memory_order_relaxed);
+        auto chunk = chunkOf(index);
+        if (chunks[chunk].load(std::memory_order_acquire) == nullptr) {
+            std::lock_guard guard(growLock);
+            if (chunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+                chunks[chunk].store(new Node[chunkSize(chunk)],
+                                    std::memory_order_release);
+            }
+        }
+        Node* node = nodeAt(index);
+        node->index = index;
+        return node;
+    }
+
+    // The free list head packs the index (plus one, zero meaning empty) of the
+    // first free node in the low half and an ABA tag in the high half.
+    Node* popFreeNode() {
+        auto head = freeHead.load(std::memory_order_acquire);
+        while (true) {
+            auto index = static_cast<std::uint32_t>(head);
+            if (index == 0) {
+                return nullptr;
+            }
+            Node* node = nodeAt(index - 1);
+            std::uint64_t next
+              = ((head >> 32) + 1) << 32
+              | node->nextFree.load(std::memory_order_relaxed);
+            if (freeHead.compare_exchange_weak(
+                  head, next, std::memory_order_acq_rel)) {
+                return node;
+            }
+        }
+    }
+
+    void pushFreeNode(Node* node) {
+        const std::uint32_t index = node->index + 1;
+        auto head = freeHead.load(std::memory_order_relaxed);
+        std::uint64_t next;
+        do {
+            node->nextFree.store(static_cast<std::uint32_t>(head),
+                                 std::memory_order_relaxed);
+            next = ((head >> 32) + 1) << 32 | index;
+        } while (!freeHead.compare_exchange_weak(
+          head, next, std::memory_order_acq_rel));
+    }
+
+    std::array<std::atomic<Node*>, kMaxChunks> chunks{};
+    std::atomic_uint32_t numFreshNodes = 0;
+    std::atomic_uint64_t freeHead = 0;
+    std::atomic_size_t numDead = 0;
+    std::mutex growLock;
+};
+
+}  // namespace mcga::threading::base
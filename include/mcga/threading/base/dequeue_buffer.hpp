@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+namespace mcga::threading::base {
+
+// Sizing policy of the buffer an immediate queue wrapper dequeues its tasks
+// into, e.g. ImmediateQueueWrapper<P, DequeueBufferPolicy<16, 64>>.
+//
+// The buffer starts with room for InitialCapacity tasks and grows with the
+// backlog of the queue, up to MaxBatchSize, which is then the most tasks a loop
+// takes off its queue in one iteration. After ShrinkAfter iterations in a row
+// that needed at most a quarter of it, the buffer shrinks back to twice the
+// largest of their batches, so a burst does not pin its memory forever. Lower
+// values save resident memory per loop, at the price of smaller batches.
+template<std::size_t InitialCapacity = 16,
+         std::size_t MaxBatchSize = 1024,
+         std::size_t ShrinkAfter = 1024>
+struct DequeueBufferPolicy {
+    static_assert(0 < InitialCapacity && InitialCapacity <= MaxBatchSize,
+                  "The initial capacity must be within (0, MaxBatchSize].");
+
+    static constexpr std::size_t kInitialCapacity = InitialCapacity;
+    static constexpr std::size_t kMaxBatchSize = MaxBatchSize;
+    static constexpr std::size_t kShrinkAfter = ShrinkAfter;
+};
+
+// The buffer of an immediate queue wrapper. Tasks are moved straight from the
+// queue into uninitialized slots, and every task is destroyed as soon as it
+// was executed, so the buffer never keeps the resources of executed tasks.
+//
+// Only the loop thread uses the buffer, except for size(), which can be
+// called from any thread.
+template<class Task, class Policy = DequeueBufferPolicy<>>
+class DequeueBuffer {
+  public:
+    DequeueBuffer() = default;
+
+    DequeueBuffer(const DequeueBuffer&) = delete;
+    DequeueBuffer& operator=(const DequeueBuffer&) = delete;
+
+    ~DequeueBuffer() {
+        std::allocator<Task>().deallocate(slots, capacity);
+    }
+
+    // The number of dequeued tasks not executed yet.
+    std::size_t size() const {
+        return numPending.load(std::memory_order_relaxed);
+    }
+
+    std::size_t getCapacity() const {
+        return capacity;
+    }
+
+    // Resizes the buffer for a backlog of tasks, and returns how many of them
+    // to dequeue, at most the capacity of the buffer. Called on every
+    // iteration, even with no backlog, and only while the buffer is empty.
+    std::size_t reserve(std::size_t backlog) {
+        if (backlog > capacity && capacity < Policy::kMaxBatchSize) {
+            reallocate(std::min(Policy::kMaxBatchSize, std::bit_ceil(backlog)));
+        } else if (backlog <= capacity / 4
+                   && capacity > Policy::kInitialCapacity) {
+            lowLoadPeak = std::max(lowLoadPeak, backlog);
+            numLowLoadIterations += 1;
+            if (numLowLoadIterations >= Policy::kShrinkAfter) {
+                reallocate(std::max(Policy::kInitialCapacity,
+                                    std::bit_ceil(lowLoadPeak * 2)));
+            }
+        } else {
+            numLowLoadIterations = 0;
+            lowLoadPeak = 0;
+        }
+        return std::min(backlog, capacity);
+    }
+
+    // Fills the buffer with dequeueBulk(it, maxCount), which moves at most
+    // maxCount tasks into the output iterator it and returns how many it
+    // moved. Returns that number.
+    template<class DequeueBulk>
+    std::size_t fill(std::size_t maxCount, const DequeueBulk& dequeueBulk) {
+        numFilled = dequeueBulk(Inserter(slots), std::min(maxCount, capacity));
+        numPending.store(numFilled, std::memory_order_relaxed);
+        return numFilled;
+    }
+
+    // Executes the tasks in the buffer, in order, and empties it. Processors
+    // that define executeBatch(std::span<Task>) get all of them in one call,
+    // the others get one executeTask() call per task.
+    template<class Processor>
+    void execute(Processor* processor) {
+        if constexpr (requires(std::span<Task> batch) {
+                          processor->executeBatch(batch);
+                      }) {
+            processor->executeBatch(std::span<Task>(slots, numFilled));
+            std::destroy_n(slots, numFilled);
+            numPending.store(0, std::memory_order_relaxed);
+        } else {
+            for (std::size_t i = 0; i < numFilled; ++i) {
+                processor->executeTask(slots[i]);
+                std::destroy_at(slots + i);
+                numPending.store(numFilled - i - 1, std::memory_order_relaxed);
+            }
+        }
+        numFilled = 0;
+    }
+
+  private:
+    // Output iterator move-constructing every task assigned through it into
+    // the next uninitialized slot.
+    class Inserter {
+      public:
+        using iterator_category = std::output_iterator_tag;
+        using value_type = void;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = void;
+
+        explicit Inserter(Task* slot): slot(slot) {
+        }
+
+        Inserter& operator=(Task&& task) {
+            ::new (static_cast<void*>(slot)) Task(std::move(task));
+            ++slot;
+            return *this;
+        }
+
+        Inserter& operator*() {
+            return *this;
+        }
+
+        Inserter& operator++() {
+            return *this;
+        }
+
+        Inserter& operator++(int) {
+            return *this;
+        }
+
+      private:
+        Task* slot;
+    };
+
+    void reallocate(std::size_t newCapacity) {
+        std::allocator<Task> allocator;
+        allocator.deallocate(slots, capacity);
+        capacity = newCapacity;
+        slots = allocator.allocate(capacity);
+        numLowLoadIterations = 0;
+        lowLoadPeak = 0;
+    }
+
+    std::size_t capacity = Policy::kInitialCapacity;
+    Task* slots = std::allocator<Task>().allocate(capacity);
+    std::size_t numFilled = 0;
+    std::atomic_size_t numPending = 0;
+    std::size_t numLowLoadIterations = 0;
+    std::size_t lowLoadPeak = 0;
+};
+
+}  // namespace mcga::threading::base
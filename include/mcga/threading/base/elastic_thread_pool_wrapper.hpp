@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "thread_wrapper.hpp"
+#include "worker_dispatch.hpp"
+
+namespace mcga::threading::base {
+
+struct ElasticPoolOptions {
+    // Never retired, so a pool always has at least one worker. Tasks enqueued
+    // with a key only go to these workers, so keyed work does not scale past
+    // minThreads: raise it for pools that mostly see keyed work.
+    std::size_t minThreads = 1;
+    std::size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1U);
+
+    // A worker is added when the immediate tasks waiting in the pool stayed
+    // above growBacklog per active worker for growAfter.
+    std::size_t growBacklog = 64;
+    std::chrono::milliseconds growAfter{20};
+
+    // An added worker takes half of the queued immediate tasks of the
+    // busiest worker, so the backlog that made the pool grow is shared
+    // instead of only the tasks enqueued afterwards. Moved tasks can run
+    // before tasks enqueued earlier into the same worker, which breaks the
+    // order of the tasks of a key, so only turn this on for pools that are
+    // not given keyed work.
+    bool moveBacklogOnGrow = false;
+
+    // The last added worker is retired when its queue stayed empty for
+    // idleTimeout.
+    std::chrono::milliseconds idleTimeout{1000};
+
+    // How often the pool checks whether to add or retire a worker.
+    std::chrono::milliseconds checkInterval{5};
+};
+
+// Thread pool that runs between minThreads and maxThreads workers, depending
+// on load, instead of a fixed number of them. All maxThreads event loops are
+// allocated upfront and only their threads come and go, so producers pick a
+// worker among the active ones without taking a lock.
+//
+// A supervisor thread adds and retires workers. An added worker can take half
+// of the backlog of the busiest one, see moveBacklogOnGrow. A retired worker
+// finishes the task it is running, if any, without holding up the
+// supervisor, which joins it on a later check and then moves its pending
+// immediate tasks to the active workers. Until then it cannot be added back.
+// Tasks enqueued into a worker while it was retired are moved on the next
+// check. Delayed tasks all go to the first
+// worker, and the tasks of a key to one of the first minThreads workers,
+// which are never retired.
+//
+// Moving tasks needs a worker whose immediate queue can be dequeued from any
+// thread, like ImmediateQueueWrapper.
+template<class W,
+         class Idx,
+         class Dispatch = RoundRobinDispatch<Idx>,
+         class KeyDispatch = ModuloKeyDispatch>
+class ElasticThreadPoolWrapper {
+  private:
+    using Thread = EmbeddedThreadWrapper<W>;
+    using Clock = std::chrono::steady_clock;
+
+  public:
+    using Wrapped = W;
+    using Processor = typename W::Processor;
+    using Task = typename W::Task;
+
+    template<class... Args>
+    explicit ElasticThreadPoolWrapper(ElasticPoolOptions options,
+                                      Args&&... args)
+            : processor(std::forward<Args>(args)...), options(options),
+              running(std::max({options.maxThreads,
+                                options.minThreads,
+                                std::size_t{1}})),
+              idleSince(running.size()), retiring(running.size()) {
+        this->options.minThreads = std::max(options.minThreads, std::size_t{1});
+        this->options.maxThreads = running.size();
+        threads.reserve(running.size());
+        for (std::atomic_bool& workerRunning: running) {
+            threads.push_back(
+              std::make_unique<Thread>(&workerRunning, &processor));
+        }
+        numActive.store(this->options.minThreads);
+    }
+
+    template<class... Args>
+    explicit ElasticThreadPoolWrapper(Args&&... args)
+            : ElasticThreadPoolWrapper(ElasticPoolOptions(),
+                                       std::forward<Args>(args)...) {
+    }
+
+    ElasticThreadPoolWrapper(const ElasticThreadPoolWrapper&) = delete;
+    ElasticThreadPoolWrapper(ElasticThreadPoolWrapper&&) = delete;
+
+    ElasticThreadPoolWrapper& operator=(const ElasticThreadPoolWrapper&)
+      = delete;
+    ElasticThreadPoolWrapper& operator=(ElasticThreadPoolWrapper&&) = delete;
+
+    ~ElasticThreadPoolWrapper() {
+        stopRaw();
+    }
+
+    std::size_t sizeApprox() const {
+        std::size_t size = 0;
+        for (const std::unique_ptr<Thread>& thread: threads) {
+            size += thread->sizeApprox();
+        }
+        return size;
+    }
+
+    std::size_t getNumActiveWorkers() const {
+        return numActive.load(std::memory_order_acquire);
+    }
+
+    bool isRunning() const {
+        return started.load();
+    }
+
+    void start() {
+        while (isInStartOrStop.test_and_set()) {
+            std::this_thread::yield();
+        }
+        if (!started.load()) {
+            started.store(true);
+            const auto now = Clock::now();
+            for (std::size_t i = 0; i < getNumActiveWorkers(); ++i) {
+                startWorker(i, now);
+            }
+            {
+                std::lock_guard guard(supervisorLock);
+                supervising = true;
+            }
+            supervisor = std::thread([this] {
+                supervise();
+            });
+        }
+        isInStartOrStop.clear();
+    }
+
+    void stop() {
+        stopRaw();
+        isInStartOrStop.clear();
+    }
+
+    Processor* getProcessor() {
+        return &processor;
+    }
+
+  protected:
+    Wrapped* getWorker() {
+        return threads[dispatch.select(activeThreads())]->getWorker();
+    }
+
+    Wrapped* getDelayedTaskWorker() {
+        return threads[0]->getWorker();
+    }
+
+    std::size_t getNumWorkers() const {
+        return getNumActiveWorkers();
+    }
+
+    // All workers, including the retired ones.
+    template<class F>
+    void forEachWorker(const F& func) {
+        for (std::unique_ptr<Thread>& thread: threads) {
+            func(thread->getWorker());
+        }
+    }
+
+    template<class Key>
+    Wrapped* getWorkerForKey(const Key& key) {
+        return threads[keyDispatch.select(std::hash<Key>()(key),
+                                          options.minThreads)]
+          ->getWorker();
+    }
+
+  private:
+    std::span<const std::unique_ptr<Thread>> activeThreads() const {
+        return {threads.data(), getNumActiveWorkers()};
+    }
+
+    std::size_t backlogOf(std::size_t index) {
+        return threads[index]->getWorker()->getImmediateQueueSize();
+    }
+
+    void startWorker(std::size_t index, Clock::time_point now) {
+        idleSince[index] = now;
+        running[index].store(true);
+        threads[index]->start();
+    }
+
+    void stopWorker(std::size_t index) {
+        running[index].store(false);
+        threads[index]->stop();
+    }
+
+    // Stops the worker without waiting for the task it is running.
+    void retireWorker(std::size_t index) {
+        running[index].store(false);
+        threads[index]->wakeToStop();
+        retiring[index] = true;
+    }
+
+    // Joins the retired workers whose thread returned from its loop.
+    void joinRetiredWorkers() {
+        for (auto i = getNumActiveWorkers(); i < options.maxThreads; ++i) {
+            if (retiring[i] && threads[i]->hasThreadExited()) {
+                stopWorker(i);
+                retiring[i] = false;
+            }
+        }
+    }
+
+    // Must only be called for a worker whose thread is stopped.
+    void migrate(std::size_t index) {
+        Task task;
+        while (threads[index]->getWorker()->tryDequeue(task)) {
+            getWorker()->enqueue(std::move(task));
+        }
+    }
+
+    // Moves half of the backlog of the busiest active worker to the worker
+    // that was just started at index.
+    void rebalance(std::size_t index) {
+        std::size_t busiest = 0;
+        for (std::size_t i = 1; i < index; ++i) {
+            if (backlogOf(i) > backlogOf(busiest)) {
+                busiest = i;
+            }
+        }
+        Wrapped* from = threads[busiest]->getWorker();
+        Wrapped* to = threads[index]->getWorker();
+        auto numToMove = backlogOf(busiest) / 2;
+        Task task;
+        while (numToMove > 0 && from->tryDequeue(task)) {
+            to->enqueue(std::move(task));
+            numToMove -= 1;
+        }
+    }
+
+    void supervise() {
+        std::unique_lock lock(supervisorLock);
+        while (!supervisorCondition.wait_for(
+          lock, options.checkInterval, [this] {
+              return !supervising;
+          })) {
+            lock.unlock();
+            check(Clock::now());
+            lock.lock();
+        }
+    }
+
+    void check(Clock::time_point now) {
+        joinRetiredWorkers();
+        const auto numActiveNow = getNumActiveWorkers();
+        std::size_t backlog = 0;
+        for (std::size_t i = 0; i < numActiveNow; ++i) {
+            auto size = backlogOf(i);
+            if (size > 0) {
+                idleSince[i] = now;
+            }
+            backlog += size;
+        }
+        if (backlog > options.growBacklog * numActiveNow) {
+            if (overloadedSince == Clock::time_point::max()) {
+                overloadedSince = now;
+            }
+            if (now - overloadedSince >= options.growAfter
+                && numActiveNow < options.maxThreads
+                && !retiring[numActiveNow]) {
+                startWorker(numActiveNow, now);
+                numActive.store(numActiveNow + 1, std::memory_order_release);
+                overloadedSince = Clock::time_point::max();
+                if (options.moveBacklogOnGrow) {
+                    rebalance(numActiveNow);
+                }
+            }
+        } else {
+            overloadedSince = Clock::time_point::max();
+            if (numActiveNow > options.minThreads
+                && now - idleSince[numActiveNow - 1] >= options.idleTimeout) {
+                // Producers stop picking it first, then it is stopped.
+                numActive.store(numActiveNow - 1, std::memory_order_release);
+                retireWorker(numActiveNow - 1);
+            }
+        }
+        // Also picks up the tasks enqueued by producers that chose a worker
+        // right before it was retired.
+        for (auto i = getNumActiveWorkers(); i < options.maxThreads; ++i) {
+            if (!retiring[i] && backlogOf(i) > 0) {
+                migrate(i);
+            }
+        }
+    }
+
+    void stopRaw() {
+        while (isInStartOrStop.test_and_set()) {
+            std::this_thread::yield();
+        }
+        if (started.load()) {
+            started.store(false);
+            {
+                std::lock_guard guard(supervisorLock);
+                supervising = false;
+            }
+            supervisorCondition.notify_one();
+            supervisor.join();
+            // Also joins the retired workers the supervisor did not join.
+            for (std::size_t i = 0; i < options.maxThreads; ++i) {
+                stopWorker(i);
+                retiring[i] = false;
+            }
+            // The pool starts again with minThreads workers, so the tasks of
+            // the others must not be left behind.
+            numActive.store(options.minThreads, std::memory_order_release);
+            for (auto i = options.minThreads; i < options.maxThreads; ++i) {
+                migrate(i);
+            }
+        }
+    }
+
+    Processor processor;
+    Dispatch dispatch;
+    KeyDispatch keyDispatch;
+    ElasticPoolOptions options;
+    std::atomic_flag isInStartOrStop = ATOMIC_FLAG_INIT;
+    std::atomic_bool started = false;
+    std::vector<std::atomic_bool> running;
+    std::vector<std::unique_ptr<Thread>> threads;
+    std::atomic_size_t numActive = 0;
+
+    // Only touched by the supervisor thread, or while it is stopped.
+    std::vector<Clock::time_point> idleSince;
+    std::vector<bool> retiring;
+    Clock::time_point overloadedSince = Clock::time_point::max();
+
+    std::thread supervisor;
+    std::mutex supervisorLock;
+    std::condition_variable supervisorCondition;
+    bool supervising = false;
+};
+
+}  // namespace mcga::threading::base
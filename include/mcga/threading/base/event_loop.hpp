@@ -1,48 +1,293 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <queue>
+#include <span>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "bounded_immediate_queue_wrapper.hpp"
+#include "coroutine.hpp"
+#include "deadline_immediate_queue_wrapper.hpp"
 #include "delayed_queue_wrapper.hpp"
+#include "future.hpp"
 #include "immediate_queue_wrapper.hpp"
-#include "loop_tick_duration.hpp"
+#include "loop_metrics.hpp"
+#include "mpsc_immediate_queue_wrapper.hpp"
+#include "pooled_delayed_queue_wrapper.hpp"
+#include "priority_immediate_queue_wrapper.hpp"
+#include "shared_immediate_queue_wrapper.hpp"
 #include "sp_immediate_queue_wrapper.hpp"
+#include "stealing_immediate_queue_wrapper.hpp"
+#include "timing_wheel_delayed_queue_wrapper.hpp"
+#include "wait_strategy.hpp"
 
 namespace mcga::threading::base {
 
 template<class P,
          class ImmediateQueue = base::ImmediateQueueWrapper<P>,
-         class DelayedQueue = base::DelayedQueueWrapper<P>>
+         class DelayedQueue = base::DelayedQueueWrapper<P>,
+         class WaitStrategy = base::DefaultWaitStrategy,
+         class Metrics = base::NoLoopMetrics>
 class EventLoop : public DelayedQueue, public ImmediateQueue {
   public:
     using Processor = P;
     using Task = typename Processor::Task;
+    using Clock = typename DelayedQueue::Clock;
+    using Delay = typename DelayedQueue::Delay;
+    using DelayedTaskPtr = typename DelayedQueue::DelayedTaskPtr;
+
+    // A bounded immediate queue reports whether it took the task, and the
+    // loop is not woken up for a task it rejected or dropped.
+    void enqueue(Task task) {
+        if constexpr (std::is_void_v<decltype(ImmediateQueue::enqueue(
+                        std::move(task)))>) {
+            ImmediateQueue::enqueue(std::move(task));
+            waitStrategy.notify();
+        } else if (ImmediateQueue::enqueue(std::move(task))) {
+            waitStrategy.notify();
+        }
+    }
+
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        if constexpr (std::is_void_v<decltype(ImmediateQueue::enqueueBulk(
+                        first, count))>) {
+            ImmediateQueue::enqueueBulk(first, count);
+            waitStrategy.notify();
+        } else if (ImmediateQueue::enqueueBulk(first, count) > 0) {
+            waitStrategy.notify();
+        }
+    }
+
+    // Only available with a priority immediate queue.
+    void enqueue(Task task, Priority priority) {
+        ImmediateQueue::enqueue(std::move(task), priority);
+        waitStrategy.notify();
+    }
+
+    // Only available with a deadline immediate queue.
+    void enqueue(Task task, Deadline deadline) {
+        ImmediateQueue::enqueue(std::move(task), deadline);
+        waitStrategy.notify();
+    }
+
+    // The overloads below are only available with a bounded immediate queue.
+
+    bool tryEnqueue(Task&& task) {
+        bool enqueued = ImmediateQueue::tryEnqueue(std::move(task));
+        if (enqueued) {
+            waitStrategy.notify();
+        }
+        return enqueued;
+    }
+
+    template<class Rep, class Ratio>
+    bool tryEnqueueFor(Task&& task,
+                       const std::chrono::duration<Rep, Ratio>& timeout) {
+        bool enqueued = ImmediateQueue::tryEnqueueFor(std::move(task), timeout);
+        if (enqueued) {
+            waitStrategy.notify();
+        }
+        return enqueued;
+    }
+
+    DelayedTaskPtr enqueueDelayed(Task task,
+                                  const Delay& delay,
+                                  const TimerOptions& options = {}) {
+        auto delayedTask
+          = DelayedQueue::enqueueDelayed(std::move(task), delay, options);
+        waitStrategy.notify();
+        return delayedTask;
+    }
+
+    DelayedTaskPtr enqueueInterval(Task task,
+                                   const Delay& delay,
+                                   const TimerOptions& options = {}) {
+        auto delayedTask
+          = DelayedQueue::enqueueInterval(std::move(task), delay, options);
+        waitStrategy.notify();
+        return delayedTask;
+    }
+
+    // Only available with an enabled metrics policy, like LoopMetrics. Can be
+    // called from any thread.
+    LoopStats stats() const
+        requires Metrics::kEnabled
+    {
+        return metrics.stats();
+    }
+
+    // Only available with a metrics policy that tracks latency, like
+    // LatencyLoopMetrics.
+    LatencyStats latencies() const
+        requires requires(const Metrics& metrics) { metrics.latencies(); }
+    {
+        return metrics.latencies();
+    }
 
   private:
+    static constexpr std::size_t kSpinsPerClockRead = 64;
+
     std::size_t sizeApprox() const {
         return this->getImmediateQueueSize() + this->getDelayedQueueSize();
     }
 
     void start(std::atomic_bool* running, Processor* processor) {
+        auto shouldWake = [this, running] {
+            return !running->load() || this->getImmediateQueueSize() > 0;
+        };
+        auto nextDeadline = [this] {
+            return this->getNextDelayedTimePoint();
+        };
+        if constexpr (requires { metrics.loopStarted(); }) {
+            metrics.loopStarted();
+        }
+        // Timers are checked against this cached time point instead of the
+        // clock. It is refreshed after every iteration that executed
+        // something, whenever the wait strategy gave up the CPU and every
+        // kSpinsPerClockRead spins otherwise, and only while a delayed task is
+        // pending, so a spinning loop mostly does not read the clock at all.
+        auto now = Clock::now();
+        std::size_t numSpins = 0;
         while (running->load()) {
-            while (this->executeDelayed(processor)
-                   || this->executeImmediate(processor)) {
-                std::this_thread::yield();
+            auto iteration = metrics.iterationStarted(
+              Metrics::kEnabled ? this->getImmediateQueueSize() : 0);
+            bool busy = executeDelayedMetered(processor, now)
+              || executeImmediateMetered(processor);
+            if (busy) {
+                waitStrategy.reset();
+                refreshClock(&now);
+            } else if (waitStrategy.idle(shouldWake, nextDeadline)
+                       || ++numSpins % kSpinsPerClockRead == 0) {
+                refreshClock(&now);
             }
-            std::this_thread::sleep_for(base::loopTickDuration);
+            metrics.iterationEnded(iteration, busy);
         }
     }
 
+    void refreshClock(typename Clock::time_point* now) const {
+        if (this->getDelayedQueueSize() > 0) {
+            *now = Clock::now();
+        }
+    }
+
+    // With metrics disabled, these are the plain executeDelayed() and
+    // executeImmediate(), without any hook.
+
+    bool executeDelayedMetered(Processor* processor,
+                               const typename Clock::time_point& now) {
+        if constexpr (Metrics::kEnabled) {
+            return this->executeDelayed(
+              processor, now, [this](const auto& dueTimePoint, auto& task) {
+                  metrics.delayedTaskExecuted(dueTimePoint, task);
+              });
+        } else {
+            return this->executeDelayed(processor, now);
+        }
+    }
+
+    bool executeImmediateMetered(Processor* processor) {
+        if constexpr (Metrics::kEnabled) {
+            return this->executeImmediate(
+              processor, [this](std::size_t numDequeued) {
+                  metrics.immediateBatch(numDequeued);
+              });
+        } else {
+            return this->executeImmediate(processor);
+        }
+    }
+
+    void wakeUp() {
+        waitStrategy.notify();
+    }
+
+    WaitStrategy waitStrategy;
+    [[no_unique_address]] Metrics metrics;
+
     template<class T>
     friend class ThreadWrapperBase;
+
+    // Moves the pending tasks of the workers it retires.
+    template<class T, class I, class D, class K>
+    friend class ElasticThreadPoolWrapper;
 };
 
 template<class P>
 using SPEventLoop = EventLoop<P, SPImmediateQueueWrapper<P>>;
 
+// Consumes its immediate tasks through an MPSCQueue, see
+// MPSCImmediateQueueWrapper.
+template<class P>
+using MPSCEventLoop = EventLoop<P, MPSCImmediateQueueWrapper<P>>;
+
+// Holds at most Capacity immediate tasks, see BoundedImmediateQueueWrapper.
+template<class P, std::size_t Capacity, class Overflow = BlockOnOverflow>
+using BoundedEventLoop
+  = EventLoop<P,
+              BoundedImmediateQueueWrapper<ImmediateQueueWrapper<P>,
+                                           Capacity,
+                                           Overflow>>;
+
+template<class P, std::size_t Capacity, class Overflow = BlockOnOverflow>
+using BoundedSPEventLoop
+  = EventLoop<P,
+              BoundedImmediateQueueWrapper<SPImmediateQueueWrapper<P>,
+                                           Capacity,
+                                           Overflow>>;
+
+// Drains its NumLanes immediate lanes by priority, see
+// PriorityImmediateQueueWrapper.
+template<class P,
+         std::size_t NumLanes = 2,
+         std::size_t DrainRatio = kDefaultDrainRatio>
+using PriorityEventLoop
+  = EventLoop<P, PriorityImmediateQueueWrapper<P, NumLanes, DrainRatio>>;
+
+// Executes its immediate tasks earliest deadline first, see
+// DeadlineImmediateQueueWrapper.
+template<class P, class Late = ShedLateTasks>
+using DeadlineEventLoop = EventLoop<P, DeadlineImmediateQueueWrapper<P, Late>>;
+
+// Idle workers poll their siblings for work to steal, so they must not park.
+template<class P>
+using WorkStealingEventLoop = EventLoop<P,
+                                       StealingImmediateQueueWrapper<P>,
+                                       DelayedQueueWrapper<P>,
+                                       SpinThenYieldWaitStrategy<>>;
+
+// Producers do not know which worker will pick up their task, so idle workers
+// poll the shared queue instead of parking.
+template<class P>
+using SharedQueueEventLoop = EventLoop<P,
+                                       SharedImmediateQueueWrapper<P>,
+                                       DelayedQueueWrapper<P>,
+                                       SpinThenYieldWaitStrategy<>>;
+
+// Keeps LoopMetrics, see EventLoop::stats().
+template<class P>
+using MeteredEventLoop = EventLoop<P,
+                                   ImmediateQueueWrapper<P>,
+                                   DelayedQueueWrapper<P>,
+                                   DefaultWaitStrategy,
+                                   LoopMetrics>;
+
+// Keeps LatencyLoopMetrics. Use it with LatencyTrackingProcessor, which
+// stamps the tasks, see EventLoop::latencies().
+template<class P>
+using LatencyTrackedEventLoop = EventLoop<P,
+                                          ImmediateQueueWrapper<P>,
+                                          DelayedQueueWrapper<P>,
+                                          DefaultWaitStrategy,
+                                          LatencyLoopMetrics>;
+
 template<class Wrapper>
 class EventLoopConstruct : public Wrapper {
+  private:
+    static constexpr std::size_t kMinBulkChunkSize = 64;
+
   public:
     using Task = typename Wrapper::Task;
     using Delay = typename Wrapper::Wrapped::Delay;
@@ -54,20 +299,228 @@ class EventLoopConstruct : public Wrapper {
         this->getWorker()->enqueue(std::move(task));
     }
 
+    // Only available on constructs with a priority immediate queue. On pools,
+    // the task goes to the worker picked by the dispatch policy, and is only
+    // prioritized over the other tasks of that worker.
+    void enqueue(Task task, Priority priority) {
+        this->getWorker()->enqueue(std::move(task), priority);
+    }
+
+    // Runs func on the loop, and returns a Future for its result. The callable
+    // and the future's shared state take one allocation, and the enqueued
+    // task only holds a pointer to them. Needs a Task constructible from any
+    // callable, like the one of FunctionProcessor.
+    template<class F>
+    auto submit(F&& func) {
+        auto [future, runner] = packageTask(std::forward<F>(func));
+        enqueue(std::move(runner));
+        return std::move(future);
+    }
+
+    // co_await loop.schedule() resumes the awaiting coroutine on the loop.
+    // Only enqueues the coroutine handle, so there is no allocation per hop
+    // with a Task type like the one of FunctionProcessor.
+    ScheduleAwaitable<EventLoopConstruct> schedule() {
+        return ScheduleAwaitable<EventLoopConstruct>(this);
+    }
+
+    // co_await loop.sleepFor(delay) resumes the awaiting coroutine on the
+    // loop, after delay, through the loop's delayed queue.
+    template<class Rep, class Ratio>
+    SleepAwaitable<EventLoopConstruct, std::chrono::duration<Rep, Ratio>>
+      sleepFor(const std::chrono::duration<Rep, Ratio>& delay) {
+        return {this, delay};
+    }
+
+    // Moves the tasks out of [first, last) with one bulk enqueue per worker.
+    // Pools split the batch into contiguous chunks of at least
+    // kMinBulkChunkSize tasks, one chunk per worker picked by the dispatch
+    // policy, so the tasks of a chunk still run in order.
+    template<std::forward_iterator It>
+    void enqueueBulk(It first, It last) {
+        auto count = static_cast<std::size_t>(std::distance(first, last));
+        auto numChunks = std::min(
+          this->getNumWorkers(),
+          (count + kMinBulkChunkSize - 1) / kMinBulkChunkSize);
+        for (std::size_t i = 0; i < numChunks; ++i) {
+            // The first count % numChunks chunks take one extra task.
+            auto chunkSize
+              = count / numChunks + (i < count % numChunks ? 1 : 0);
+            this->getWorker()->enqueueBulk(first, chunkSize);
+            std::advance(first, chunkSize);
+        }
+    }
+
+    void enqueueBulk(std::span<Task> tasks) {
+        enqueueBulk(tasks.begin(), tasks.end());
+    }
+
+    // The methods below are only available on constructs with a deadline
+    // immediate queue. On pools, tasks are only ordered by deadline with the
+    // other tasks of the worker picked by the dispatch policy, and the
+    // callback is set on all workers.
+
+    void enqueue(Task task, Deadline deadline) {
+        this->getWorker()->enqueue(std::move(task), deadline);
+    }
+
+    template<class Callback>
+    void setLateTaskCallback(const Callback& callback) {
+        this->forEachWorker([&callback](auto* worker) {
+            worker->setLateTaskCallback(callback);
+        });
+    }
+
+    std::size_t numLateTasks() {
+        std::size_t numLate = 0;
+        this->forEachWorker([&numLate](auto* worker) {
+            numLate += worker->numLateTasks();
+        });
+        return numLate;
+    }
+
+    // The methods below are only available on constructs with a bounded
+    // immediate queue. On pools, a task is only offered to the worker picked
+    // by the dispatch policy, and the counters are summed over all workers.
+
+    // Only moves from the task if it was enqueued.
+    bool tryEnqueue(Task&& task) {
+        return this->getWorker()->tryEnqueue(std::move(task));
+    }
+
+    // Only moves from the task if it was enqueued.
+    template<class Rep, class Ratio>
+    bool tryEnqueueFor(Task&& task,
+                       const std::chrono::duration<Rep, Ratio>& timeout) {
+        return this->getWorker()->tryEnqueueFor(std::move(task), timeout);
+    }
+
+    std::size_t numRejectedTasks() {
+        std::size_t numRejected = 0;
+        this->forEachWorker([&numRejected](auto* worker) {
+            numRejected += worker->numRejectedTasks();
+        });
+        return numRejected;
+    }
+
+    std::size_t numDroppedTasks() {
+        std::size_t numDropped = 0;
+        this->forEachWorker([&numDropped](auto* worker) {
+            numDropped += worker->numDroppedTasks();
+        });
+        return numDropped;
+    }
+
+    // Only available on constructs whose loops keep metrics. On pools, the
+    // stats of all workers are aggregated, see LoopStats::operator+=.
+    LoopStats stats() {
+        LoopStats stats;
+        this->forEachWorker([&stats](auto* worker) {
+            stats += worker->stats();
+        });
+        return stats;
+    }
+
+    // Only available on constructs whose loops track latency. On pools, the
+    // histograms of all workers are merged.
+    LatencyStats latencies() {
+        LatencyStats latencies;
+        this->forEachWorker([&latencies](auto* worker) {
+            latencies += worker->latencies();
+        });
+        return latencies;
+    }
+
+    // See TimerOptions for the slack of a timer and how intervals are
+    // re-armed. By default, a timer has no slack and intervals run with a
+    // fixed delay between them.
+
     template<class Rep, class Ratio>
     DelayedTaskPtr
       enqueueDelayed(Task task,
-                     const std::chrono::duration<Rep, Ratio>& delay) {
-        return this->getWorker()->enqueueDelayed(
-          std::move(task), std::chrono::duration_cast<Delay>(delay));
+                     const std::chrono::duration<Rep, Ratio>& delay,
+                     const TimerOptions& options = {}) {
+        return delayedTaskWorker()->enqueueDelayed(
+          std::move(task), std::chrono::duration_cast<Delay>(delay), options);
     }
 
     template<class Rep, class Ratio>
     DelayedTaskPtr
       enqueueInterval(Task task,
-                      const std::chrono::duration<Rep, Ratio>& delay) {
-        return this->getWorker()->enqueueInterval(
-          std::move(task), std::chrono::duration_cast<Delay>(delay));
+                      const std::chrono::duration<Rep, Ratio>& delay,
+                      const TimerOptions& options = {}) {
+        return delayedTaskWorker()->enqueueInterval(
+          std::move(task), std::chrono::duration_cast<Delay>(delay), options);
+    }
+
+    // Cancelled delayed tasks are dead until their loop drops them. On pools,
+    // the counts are summed over all workers.
+
+    std::size_t numLiveDelayedTasks() {
+        std::size_t numLive = 0;
+        this->forEachWorker([&numLive](auto* worker) {
+            numLive += worker->numLiveDelayedTasks();
+        });
+        return numLive;
+    }
+
+    std::size_t numDeadDelayedTasks() {
+        std::size_t numDead = 0;
+        this->forEachWorker([&numDead](auto* worker) {
+            numDead += worker->numDeadDelayedTasks();
+        });
+        return numDead;
+    }
+
+    // The overloads below send all tasks for the same key to the same worker,
+    // so tasks enqueued for a key by one thread run one at a time, in order.
+    // This does not hold for the immediate tasks of pools whose workers share
+    // or steal work (SharedQueue and WorkStealing pools).
+
+    template<class Key>
+    void enqueue(const Key& key, Task task) {
+        workerForKey(key)->enqueue(std::move(task));
+    }
+
+    template<class Key, class Rep, class Ratio>
+    DelayedTaskPtr
+      enqueueDelayed(const Key& key,
+                     Task task,
+                     const std::chrono::duration<Rep, Ratio>& delay,
+                     const TimerOptions& options = {}) {
+        return workerForKey(key)->enqueueDelayed(
+          std::move(task), std::chrono::duration_cast<Delay>(delay), options);
+    }
+
+    template<class Key, class Rep, class Ratio>
+    DelayedTaskPtr
+      enqueueInterval(const Key& key,
+                      Task task,
+                      const std::chrono::duration<Rep, Ratio>& delay,
+                      const TimerOptions& options = {}) {
+        return workerForKey(key)->enqueueInterval(
+          std::move(task), std::chrono::duration_cast<Delay>(delay), options);
+    }
+
+  private:
+    auto* delayedTaskWorker() {
+        if constexpr (requires { this->getDelayedTaskWorker(); }) {
+            // Pools whose workers come and go keep delayed tasks on a worker
+            // that is never retired.
+            return this->getDelayedTaskWorker();
+        } else {
+            return this->getWorker();
+        }
+    }
+
+    template<class Key>
+    auto* workerForKey(const Key& key) {
+        if constexpr (requires { this->getWorkerForKey(key); }) {
+            return this->getWorkerForKey(key);
+        } else {
+            // A single thread trivially keeps every key on one worker.
+            return this->getWorker();
+        }
     }
 };
 
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mcga::threading::base {
+
+template<class R>
+class Future;
+
+// Result type of a continuation taking the value of a Future<R>.
+template<class F, class R>
+struct ContinuationResult {
+    using type = std::invoke_result_t<F&, R>;
+};
+
+template<class F>
+struct ContinuationResult<F, void> {
+    using type = std::invoke_result_t<F&>;
+};
+
+class FutureContinuation {
+  public:
+    // Called once, by the thread that makes the result available.
+    virtual void schedule() = 0;
+
+  protected:
+    ~FutureContinuation() = default;
+};
+
+// Shared state of a Future<R>: the result (a value or an exception) and the
+// continuation to schedule when the result becomes available. Waiting uses
+// std::atomic::wait(), so a blocked get() costs no mutex and no condition
+// variable.
+template<class R>
+class FutureState {
+    using Value = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+  public:
+    virtual ~FutureState() = default;
+
+    void addRef() {
+        numRefs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() {
+        if (numRefs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    bool isReady() const {
+        return continuation.load(std::memory_order_acquire) == readyMarker();
+    }
+
+    void wait() const {
+        while (!isReady()) {
+            readyFlag.wait(0, std::memory_order_acquire);
+        }
+    }
+
+    template<class... Args>
+    void setValue(Args&&... args) {
+        result.template emplace<1>(std::forward<Args>(args)...);
+        markReady();
+    }
+
+    void setException(std::exception_ptr exception) {
+        result.template emplace<2>(std::move(exception));
+        markReady();
+    }
+
+    // Only valid once the state is ready. Rethrows the exception, if any.
+    R takeValue() {
+        if (result.index() == 2) {
+            std::rethrow_exception(std::get<2>(result));
+        }
+        if constexpr (!std::is_void_v<R>) {
+            return std::move(std::get<1>(result));
+        }
+    }
+
+    std::exception_ptr getException() const {
+        return result.index() == 2 ? std::get<2>(result) : nullptr;
+    }
+
+    // Schedules the continuation right away if the state is already ready.
+    void setContinuation(FutureContinuation* next) {
+        FutureContinuation* expected = nullptr;
+        if (!continuation.compare_exchange_strong(
+              expected, next, std::memory_order_acq_rel)) {
+            next->schedule();
+        }
+    }
+
+  protected:
+    // Starts with one reference held by the Future and one held by whoever
+    // produces the result.
+    std::atomic_int numRefs = 2;
+
+  private:
+    static FutureContinuation* readyMarker() {
+        class ReadyMarker : public FutureContinuation {
+          public:
+            void schedule() override {
+            }
+        };
+        static ReadyMarker marker;
+        return &marker;
+    }
+
+    void markReady() {
+        auto* next
+          = continuation.exchange(readyMarker(), std::memory_order_acq_rel);
+        if (next != nullptr) {
+            next->schedule();
+        } else {
+            readyFlag.store(1, std::memory_order_release);
+            readyFlag.notify_all();
+        }
+    }
+
+    std::variant<std::monostate, Value, std::exception_ptr> result;
+    std::atomic<FutureContinuation*> continuation = nullptr;
+    // Only used for waiting: libstdc++ waits on 32-bit atomics with a futex
+    // directly, but on pointers through a much slower proxy.
+    std::atomic<std::uint32_t> readyFlag = 0;
+};
+
+// A state whose result is produced by running a task on an event loop.
+template<class R>
+class RunnableFutureState : public FutureState<R> {
+  public:
+    void run() {
+        if (!ran.test_and_set()) {
+            try {
+                execute();
+            } catch (...) {
+                this->setException(std::current_exception());
+            }
+        }
+    }
+
+    void addRunner() {
+        numRunners.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void releaseRunner() {
+        if (numRunners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (!ran.test_and_set()) {
+                this->setException(std::make_exception_ptr(
+                  std::future_error(std::future_errc::broken_promise)));
+            }
+            this->release();
+        }
+    }
+
+  protected:
+    // Calls setValue(), or throws.
+    virtual void execute() = 0;
+
+  private:
+    std::atomic_int numRunners = 0;
+    std::atomic_flag ran = ATOMIC_FLAG_INIT;
+};
+
+// The task enqueued in a loop to run a RunnableFutureState. Only holds a
+// pointer, so it fits in the small buffer of std::function. If every copy of
+// it is destroyed without running (the loop was destroyed first, or a bounded
+// queue dropped it), the future fails with std::future_errc::broken_promise
+// instead of waiting forever.
+template<class R>
+class FutureRunner {
+  public:
+    explicit FutureRunner(RunnableFutureState<R>* state): state(state) {
+        state->addRunner();
+    }
+
+    FutureRunner(const FutureRunner& other): state(other.state) {
+        if (state != nullptr) {
+            state->addRunner();
+        }
+    }
+
+    FutureRunner(FutureRunner&& other) noexcept
+            : state(std::exchange(other.state, nullptr)) {
+    }
+
+    FutureRunner& operator=(FutureRunner other) noexcept {
+        std::swap(state, other.state);
+        return *this;
+    }
+
+    ~FutureRunner() {
+        if (state != nullptr) {
+            state->releaseRunner();
+        }
+    }
+
+    void operator()() const {
+        state->run();
+    }
+
+  private:
+    RunnableFutureState<R>* state;
+};
+
+template<class R, class F>
+class PackagedFutureState : public RunnableFutureState<R> {
+  public:
+    explicit PackagedFutureState(F func): func(std::move(func)) {
+    }
+
+  private:
+    void execute() override {
+        if constexpr (std::is_void_v<R>) {
+            func();
+            this->setValue();
+        } else {
+            this->setValue(func());
+        }
+    }
+
+    F func;
+};
+
+// Runs func on loop with the value of prev, once prev is ready. If prev
+// failed, fails with the same exception without calling func.
+template<class R, class F, class Loop, class PrevR>
+class ContinuationFutureState
+        : public RunnableFutureState<R>
+        , public FutureContinuation {
+  public:
+    ContinuationFutureState(F func, Loop* loop, FutureState<PrevR>* prev)
+            : func(std::move(func)), loop(loop), prev(prev) {
+    }
+
+    ~ContinuationFutureState() override {
+        prev->release();
+    }
+
+    void schedule() override {
+        loop->enqueue(FutureRunner<R>(this));
+    }
+
+  private:
+    void execute() override {
+        if (auto exception = prev->getException()) {
+            this->setException(std::move(exception));
+        } else if constexpr (std::is_void_v<PrevR>) {
+            setResult([this] {
+                return func();
+            });
+        } else {
+            setResult([this] {
+                return func(prev->takeValue());
+            });
+        }
+    }
+
+    template<class Invoke>
+    void setResult(const Invoke& invoke) {
+        if constexpr (std::is_void_v<R>) {
+            invoke();
+            this->setValue();
+        } else {
+            this->setValue(invoke());
+        }
+    }
+
+    F func;
+    Loop* loop;
+    FutureState<PrevR>* prev;
+};
+
+// Wraps func in a state and the task to enqueue to run it, for
+// EventLoopConstruct::submit(). The callable and the state take a single
+// allocation.
+template<class F>
+auto packageTask(F&& func) {
+    using R = std::invoke_result_t<std::decay_t<F>&>;
+    auto* state
+      = new PackagedFutureState<R, std::decay_t<F>>(std::forward<F>(func));
+    return std::make_pair(Future<R>(state), FutureRunner<R>(state));
+}
+
+// Result of a task submitted to an event loop. Move-only, and consumed by
+// get() and then(). Like std::future, every call but isValid() throws
+// std::future_error(no_state) on a future that is not valid.
+template<class R>
+class Future {
+  public:
+    Future() = default;
+
+    // Takes over one reference to the state.
+    explicit Future(FutureState<R>* state): state(state) {
+    }
+
+    bool isValid() const {
+        return state != nullptr;
+    }
+
+    // Does not block.
+    bool isReady() const {
+        checkValid();
+        return state->isReady();
+    }
+
+    void wait() const {
+        checkValid();
+        state->wait();
+    }
+
+    // Blocks until the result is available, and returns it or rethrows the
+    // exception the task threw.
+    R get() {
+        checkValid();
+        auto owned = std::move(state);
+        owned->wait();
+        return owned->takeValue();
+    }
+
+    // Once the result is available, runs func on loop with it (or with no
+    // argument for a Future<void>), and returns a Future for what func
+    // returns. loop must outlive the continuation.
+    template<class Loop, class F>
+    auto then(Loop& loop, F&& func)
+      -> Future<typename ContinuationResult<std::decay_t<F>, R>::type> {
+        using NextR = typename ContinuationResult<std::decay_t<F>, R>::type;
+        using NextState
+          = ContinuationFutureState<NextR, std::decay_t<F>, Loop, R>;
+        checkValid();
+        // The continuation takes over our reference to this state.
+        FutureState<R>* prev = state.release();
+        auto* next = new NextState(std::forward<F>(func), &loop, prev);
+        prev->setContinuation(next);
+        return Future<NextR>(next);
+    }
+
+  private:
+    void checkValid() const {
+        if (!isValid()) {
+            throw std::future_error(std::future_errc::no_state);
+        }
+    }
+
+    struct Releaser {
+        void operator()(FutureState<R>* state) const {
+            state->release();
+        }
+    };
+
+    std::unique_ptr<FutureState<R>, Releaser> state;
+};
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace mcga::threading::base {
+
+struct LatencyReport {
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds p999{0};
+    std::chrono::nanoseconds max{0};
+};
+
+// HDR-style histogram of durations in nanoseconds. Every power of two is split
+// into kNumSubBuckets linear buckets, so a reported percentile is at most
+// 1 / kNumSubBuckets above the actual value, whatever its magnitude.
+// Histograms of different loops can be merged with operator+=.
+class LatencyHistogram {
+  public:
+    static constexpr std::size_t kSubBucketBits = 4;
+    static constexpr std::size_t kNumSubBuckets = 1U << kSubBucketBits;
+    // Values below kNumSubBuckets get one bucket each, and the values of
+    // every larger power of two get kNumSubBuckets buckets.
+    static constexpr std::size_t kNumBuckets
+      = kNumSubBuckets + (64 - kSubBucketBits) * kNumSubBuckets;
+
+    static std::size_t bucketFor(std::uint64_t value) {
+        if (value < kNumSubBuckets) {
+            return value;
+        }
+        auto exponent = static_cast<std::size_t>(std::bit_width(value)) - 1;
+        auto shift = exponent - kSubBucketBits;
+        auto subBucket = (value >> shift) & (kNumSubBuckets - 1);
+        return kNumSubBuckets + shift * kNumSubBuckets + subBucket;
+    }
+
+    // The largest value that falls in bucket.
+    static std::uint64_t bucketUpperBound(std::size_t bucket) {
+        if (bucket < kNumSubBuckets) {
+            return bucket;
+        }
+        auto shift = (bucket - kNumSubBuckets) / kNumSubBuckets;
+        auto subBucket = (bucket - kNumSubBuckets) % kNumSubBuckets;
+        auto lowerBound = (kNumSubBuckets + subBucket) << shift;
+        return lowerBound + ((std::uint64_t{1} << shift) - 1);
+    }
+
+    void record(std::uint64_t value) {
+        buckets[bucketFor(value)] += 1;
+        numValues += 1;
+        maxValue = std::max(maxValue, value);
+    }
+
+    std::uint64_t count() const {
+        return numValues;
+    }
+
+    std::chrono::nanoseconds max() const {
+        return std::chrono::nanoseconds(maxValue);
+    }
+
+    // The smallest recorded value that percent% of the values are at most,
+    // rounded up to the end of its bucket.
+    std::chrono::nanoseconds percentile(double percent) const {
+        if (numValues == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        auto rank = static_cast<std::uint64_t>(
+          std::ceil(percent / 100.0 * static_cast<double>(numValues)));
+        rank = std::clamp(rank, std::uint64_t{1}, numValues);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kNumBuckets; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds(
+                  std::min(bucketUpperBound(i), maxValue));
+            }
+        }
+        return max();
+    }
+
+    LatencyReport report() const {
+        return {numValues, percentile(50), percentile(99), percentile(99.9),
+                max()};
+    }
+
+    LatencyHistogram& operator+=(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < kNumBuckets; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        numValues += other.numValues;
+        maxValue = std::max(maxValue, other.maxValue);
+        return *this;
+    }
+
+  private:
+    std::array<std::uint64_t, kNumBuckets> buckets{};
+    std::uint64_t numValues = 0;
+    std::uint64_t maxValue = 0;
+
+    friend class LatencyRecorder;
+};
+
+// Queueing delay is the time from enqueue() (or from when a delayed task was
+// due) to the start of the task's execution.
+struct LatencyStats {
+    LatencyHistogram queueingDelay;
+    LatencyHistogram executionTime;
+
+    LatencyStats& operator+=(const LatencyStats& other) {
+        queueingDelay += other.queueingDelay;
+        executionTime += other.executionTime;
+        return *this;
+    }
+};
+
+// The histograms of one loop. Only written by the loop thread, which finds
+// its recorder through current(), and can be read from any thread through
+// stats().
+class LatencyRecorder {
+  public:
+    // The recorder of the loop running on this thread, if it tracks latency.
+    static LatencyRecorder*& current() {
+        thread_local LatencyRecorder* recorder = nullptr;
+        return recorder;
+    }
+
+    void record(std::chrono::nanoseconds delay,
+                std::chrono::nanoseconds duration) {
+        queueingDelay.record(toValue(delay));
+        executionTime.record(toValue(duration));
+    }
+
+    LatencyStats stats() const {
+        return {queueingDelay.snapshot(), executionTime.snapshot()};
+    }
+
+  private:
+    // Single-writer, so relaxed loads and stores are enough.
+    class AtomicHistogram {
+      public:
+        void record(std::uint64_t value) {
+            increment(buckets[LatencyHistogram::bucketFor(value)]);
+            increment(numValues);
+            if (value > maxValue.load(std::memory_order_relaxed)) {
+                maxValue.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        LatencyHistogram snapshot() const {
+            LatencyHistogram histogram;
+            for (std::size_t i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+                histogram.buckets[i]
+                  = buckets[i].load(std::memory_order_relaxed);
+            }
+            histogram.numValues = numValues.load(std::memory_order_relaxed);
+            histogram.maxValue = maxValue.load(std::memory_order_relaxed);
+            return histogram;
+        }
+
+      private:
+        static void increment(std::atomic<std::uint64_t>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<std::uint64_t>, LatencyHistogram::kNumBuckets>
+          buckets{};
+        std::atomic<std::uint64_t> numValues = 0;
+        std::atomic<std::uint64_t> maxValue = 0;
+    };
+
+    static std::uint64_t toValue(std::chrono::nanoseconds duration) {
+        return static_cast<std::uint64_t>(
+          std::max(duration.count(), decltype(duration.count()){0}));
+    }
+
+    AtomicHistogram queueingDelay;
+    AtomicHistogram executionTime;
+};
+
+}  // namespace mcga::threading::base
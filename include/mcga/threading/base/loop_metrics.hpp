@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+#include "latency_histogram.hpp"
+
+namespace mcga::threading::base {
+
+// A metrics policy is told by an EventLoop, from the loop thread only:
+//  - iterationStarted() at the start of every iteration, with the size of the
+//    immediate queue, returning a token passed back to iterationEnded(),
+//  - iterationEnded(token, busy) at the end of it, busy being whether it
+//    executed something (otherwise it was spent idling in the wait strategy),
+//  - immediateBatch(n) for every batch of n immediate tasks taken off the
+//    queue,
+//  - delayedTaskExecuted(dueTimePoint, task) right before executing a delayed
+//    task,
+//  - loopStarted(), if it has one, on the loop thread before the first
+//    iteration.
+// If kEnabled is false, the loop does not even compute the arguments.
+
+// Counts values in power-of-two buckets: bucket 0 holds 0, and bucket i > 0
+// holds the values in [2^(i - 1), 2^i). The last bucket also holds everything
+// larger.
+template<std::size_t NumBuckets>
+struct Log2Histogram {
+    std::array<std::uint64_t, NumBuckets> buckets{};
+
+    static std::size_t bucketFor(std::uint64_t value) {
+        return std::min(static_cast<std::size_t>(std::bit_width(value)),
+                        NumBuckets - 1);
+    }
+
+    Log2Histogram& operator+=(const Log2Histogram& other) {
+        for (std::size_t i = 0; i < NumBuckets; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        return *this;
+    }
+};
+
+// A snapshot of the metrics of one loop, or the sum of those of the workers
+// of a pool.
+struct LoopStats {
+    static constexpr std::size_t kNumHistogramBuckets = 24;
+
+    // Counted when a batch is taken off the queue, so this includes the tasks
+    // of the batch being executed.
+    std::uint64_t immediateTasksDequeued = 0;
+    std::uint64_t delayedTasksExecuted = 0;
+    // Sizes of the batches taken off the immediate queue.
+    Log2Histogram<kNumHistogramBuckets> batchSizes;
+    // How late delayed tasks were executed, in microseconds.
+    Log2Histogram<kNumHistogramBuckets> timerLatenessUs;
+    std::chrono::nanoseconds busyTime{0};
+    std::chrono::nanoseconds idleTime{0};
+    // The most tasks seen in the immediate queue at the start of an
+    // iteration. For a pool, the largest of its workers'.
+    std::size_t immediateQueueHighWaterMark = 0;
+
+    LoopStats& operator+=(const LoopStats& other) {
+        immediateTasksDequeued += other.immediateTasksDequeued;
+        delayedTasksExecuted += other.delayedTasksExecuted;
+        batchSizes += other.batchSizes;
+        timerLatenessUs += other.timerLatenessUs;
+        busyTime += other.busyTime;
+        idleTime += other.idleTime;
+        immediateQueueHighWaterMark = std::max(
+          immediateQueueHighWaterMark, other.immediateQueueHighWaterMark);
+        return *this;
+    }
+};
+
+class NoLoopMetrics {
+  public:
+    static constexpr bool kEnabled = false;
+
+    struct IterationToken {};
+
+    IterationToken iterationStarted(std::size_t /*immediateQueueSize*/) {
+        return {};
+    }
+
+    void iterationEnded(IterationToken /*token*/, bool /*busy*/) {
+    }
+
+    void immediateBatch(std::size_t /*numTasks*/) {
+    }
+
+    template<class TimePoint, class Task>
+    void delayedTaskExecuted(const TimePoint& /*dueTimePoint*/,
+                             Task& /*task*/) {
+    }
+};
+
+// Keeps every metric in LoopStats. Counters are only written by the loop
+// thread, with plain relaxed loads and stores instead of read-modify-writes,
+// and can be read from any thread through stats().
+class LoopMetrics {
+  public:
+    static constexpr bool kEnabled = true;
+
+    using Clock = std::chrono::steady_clock;
+    using IterationToken = Clock::time_point;
+
+    IterationToken iterationStarted(std::size_t immediateQueueSize) {
+        if (immediateQueueSize > load(immediateQueueHighWaterMark)) {
+            store(immediateQueueHighWaterMark, immediateQueueSize);
+        }
+        return Clock::now();
+    }
+
+    void iterationEnded(IterationToken token, bool busy) {
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          Clock::now() - token)
+                          .count();
+        increment(busy ? busyTimeNs : idleTimeNs, duration);
+    }
+
+    void immediateBatch(std::size_t numTasks) {
+        increment(immediateTasksDequeued, numTasks);
+        increment(batchSizes[Histogram::bucketFor(numTasks)], 1);
+    }
+
+    template<class Task>
+    void delayedTaskExecuted(const Clock::time_point& dueTimePoint,
+                             Task& /*task*/) {
+        auto lateness = std::chrono::duration_cast<std::chrono::microseconds>(
+                          Clock::now() - dueTimePoint)
+                          .count();
+        // Queues that round due times may run a task slightly early.
+        auto latenessUs = static_cast<std::uint64_t>(
+          std::max(lateness, decltype(lateness){0}));
+        increment(delayedTasksExecuted, 1);
+        increment(timerLatenessUs[Histogram::bucketFor(latenessUs)], 1);
+    }
+
+    LoopStats stats() const {
+        LoopStats stats;
+        stats.immediateTasksDequeued = load(immediateTasksDequeued);
+        stats.delayedTasksExecuted = load(delayedTasksExecuted);
+        for (std::size_t i = 0; i < kNumBuckets; ++i) {
+            stats.batchSizes.buckets[i] = load(batchSizes[i]);
+            stats.timerLatenessUs.buckets[i] = load(timerLatenessUs[i]);
+        }
+        stats.busyTime = std::chrono::nanoseconds(load(busyTimeNs));
+        stats.idleTime = std::chrono::nanoseconds(load(idleTimeNs));
+        stats.immediateQueueHighWaterMark = load(immediateQueueHighWaterMark);
+        return stats;
+    }
+
+  private:
+    static constexpr std::size_t kNumBuckets = LoopStats::kNumHistogramBuckets;
+    using Histogram = Log2Histogram<kNumBuckets>;
+    using Counter = std::atomic<std::uint64_t>;
+
+    static std::uint64_t load(const Counter& counter) {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    static void store(Counter& counter, std::uint64_t value) {
+        counter.store(value, std::memory_order_relaxed);
+    }
+
+    template<class Value>
+    static void increment(Counter& counter, Value value) {
+        store(counter, load(counter) + static_cast<std::uint64_t>(value));
+    }
+
+    Counter immediateTasksDequeued = 0;
+    Counter delayedTasksExecuted = 0;
+    std::array<Counter, kNumBuckets> batchSizes{};
+    std::array<Counter, kNumBuckets> timerLatenessUs{};
+    Counter busyTimeNs = 0;
+    Counter idleTimeNs = 0;
+    Counter immediateQueueHighWaterMark = 0;
+};
+
+// LoopMetrics, plus queueing delay and execution time histograms, see
+// LatencyStats. Only tasks stamped at enqueue, like those of
+// LatencyTrackingProcessor, are recorded. Delayed tasks are restamped with
+// the time point they were due at.
+class LatencyLoopMetrics : public LoopMetrics {
+  public:
+    void loopStarted() {
+        LatencyRecorder::current() = &recorder;
+    }
+
+    template<class Task>
+    void delayedTaskExecuted(const Clock::time_point& dueTimePoint,
+                             Task& task) {
+        LoopMetrics::delayedTaskExecuted(dueTimePoint, task);
+        if constexpr (requires { task.restamp(dueTimePoint); }) {
+            task.restamp(dueTimePoint);
+        }
+    }
+
+    LatencyStats latencies() const {
+        return recorder.stats();
+    }
+
+  private:
+    LatencyRecorder recorder;
+};
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+
+#include "dequeue_buffer.hpp"
+#include "mpsc_queue.hpp"
+
+namespace mcga::threading::base {
+
+// Immediate queue for loops with a single consumer, their own loop thread,
+// backed by an MPSCQueue instead of the multi-consumer ConcurrentQueue of
+// ImmediateQueueWrapper. Enqueueing costs a single exchange on the head of
+// the queue, and the loop dequeues by following next pointers instead of
+// scanning the sub-queues of the producers, which pays off with many
+// producers.
+//
+// The queue does not count its tasks: getImmediateQueueSize() counts a
+// non-empty queue as one task, and batches are sized after the previous one.
+//
+// Tasks can only be dequeued by the loop itself, so this queue does not suit
+// pools that move tasks between workers, like ElasticThreadPoolWrapper, nor
+// DropOldestOnOverflow.
+template<class Processor, class BufferPolicy = DequeueBufferPolicy<>>
+class MPSCImmediateQueueWrapper {
+  public:
+    using Task = typename Processor::Task;
+
+    void enqueue(Task task) {
+        queue.enqueue(std::move(task));
+    }
+
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        queue.enqueueBulk(first, count);
+    }
+
+  protected:
+    std::size_t getImmediateQueueSize() const {
+        return (queue.isEmpty() ? 0 : 1) + buffer.size();
+    }
+
+    bool executeImmediate(Processor* processor) {
+        return executeImmediate(processor, [](std::size_t /*numDequeued*/) {});
+    }
+
+    // Calls onDequeued() with the number of tasks taken off the queue, before
+    // executing them.
+    template<class OnDequeued>
+    bool executeImmediate(Processor* processor, const OnDequeued& onDequeued) {
+        // A full batch asks for a larger buffer, a small one lets it shrink.
+        std::size_t backlog = 0;
+        if (!queue.isEmpty()) {
+            backlog = lastBatchSize == buffer.getCapacity()
+                      ? 2 * lastBatchSize
+                      : std::max<std::size_t>(lastBatchSize, 1);
+        }
+        if (buffer.reserve(backlog) == 0) {
+            return false;
+        }
+        // Producers preempted before linking their tasks can leave nothing
+        // to dequeue yet, in which case the wait strategy backs off.
+        lastBatchSize = buffer.fill(
+          buffer.getCapacity(), [this](auto it, std::size_t count) {
+              return queue.tryDequeueBulk(it, count);
+          });
+        if (lastBatchSize == 0) {
+            return false;
+        }
+        onDequeued(lastBatchSize);
+        buffer.execute(processor);
+        return true;
+    }
+
+  private:
+    MPSCQueue<Task> queue;
+    DequeueBuffer<Task, BufferPolicy> buffer;
+    std::size_t lastBatchSize = 0;
+};
+
+}  // namespace mcga::threading::base
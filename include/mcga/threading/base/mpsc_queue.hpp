@@ -0,0 +1,245 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace mcga::threading::base {
+
+// Unbounded multi-producer single-consumer FIFO queue, a linked list of nodes
+// after Dmitry Vyukov's MPSC node-based queue.
+//
+// Enqueueing swaps the new node into the head with a single exchange and then
+// links it to the previous head, so producers never retry and never wait for
+// each other; a bulk enqueue links a whole chain with one exchange. Nothing
+// counts the values, so producers share no other cache line, and the
+// consumer only follows next pointers and publishes where it stopped.
+//
+// Nodes are not allocated one by one: every producer thread carves them out
+// of its own block of kNodesPerBlock nodes, so the nodes of a producer are
+// contiguous in memory, and a block is freed once all its nodes were
+// dequeued, by whichever thread dequeued the last one. A producer thread
+// holds on to its partly used block until it enqueues more or exits.
+//
+// A producer that was preempted between the exchange and the link hides the
+// nodes enqueued after its own from the consumer until it resumes, so
+// tryDequeue() can fail while isEmpty() is false.
+//
+// enqueue(), enqueueBulk() and isEmpty() can be called from any thread,
+// tryDequeue() and tryDequeueBulk() only from one consumer thread at a time.
+template<class T>
+class MPSCQueue {
+  private:
+    static constexpr std::size_t kCacheLineSize = 64;
+    static constexpr std::size_t kNodesPerBlock = 64;
+
+    struct NodeBlock;
+
+    struct Node {
+        std::atomic<Node*> next = nullptr;
+        NodeBlock* block = nullptr;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    struct NodeBlock {
+        // Nodes neither dequeued nor left unused by their producer thread.
+        std::atomic_size_t numLive = kNodesPerBlock;
+        Node nodes[kNodesPerBlock];
+    };
+
+    // The block the calling producer thread carves its nodes out of.
+    class NodeAllocator {
+      public:
+        NodeAllocator() = default;
+
+        NodeAllocator(const NodeAllocator&) = delete;
+        NodeAllocator& operator=(const NodeAllocator&) = delete;
+
+        ~NodeAllocator() {
+            if (block != nullptr) {
+                release(block, kNodesPerBlock - numUsed);
+            }
+        }
+
+        Node* allocate() {
+            if (block == nullptr || numUsed == kNodesPerBlock) {
+                // Not NodeBlock(), which would zero the storage first.
+                block = new NodeBlock;
+                numUsed = 0;
+            }
+            Node* node = &block->nodes[numUsed];
+            node->block = block;
+            numUsed += 1;
+            return node;
+        }
+
+      private:
+        NodeBlock* block = nullptr;
+        std::size_t numUsed = 0;
+    };
+
+    // Frees nodes of one block at a time, batching consecutive nodes of the
+    // same block into a single decrement.
+    class NodeReleaser {
+      public:
+        NodeReleaser() = default;
+
+        NodeReleaser(const NodeReleaser&) = delete;
+        NodeReleaser& operator=(const NodeReleaser&) = delete;
+
+        ~NodeReleaser() {
+            if (block != nullptr) {
+                release(block, count);
+            }
+        }
+
+        void add(Node* node) {
+            if (node->block != block) {
+                if (block != nullptr) {
+                    release(block, count);
+                }
+                block = node->block;
+                count = 0;
+            }
+            count += 1;
+        }
+
+      private:
+        NodeBlock* block = nullptr;
+        std::size_t count = 0;
+    };
+
+  public:
+    MPSCQueue() = default;
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    ~MPSCQueue() {
+        NodeReleaser releaser;
+        // The stub node at the tail never holds a value.
+        Node* next = tail->next.load(std::memory_order_acquire);
+        releaser.add(tail);
+        while (next != nullptr) {
+            Node* node = next;
+            next = node->next.load(std::memory_order_acquire);
+            std::destroy_at(node->value());
+            releaser.add(node);
+        }
+    }
+
+    void enqueue(T value) {
+        Node* node = makeNode(std::move(value));
+        link(node, node);
+    }
+
+    // Moves count values, starting at first, into the queue. They are
+    // dequeued in order, without values of other producers in between.
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+        Node* chainFirst = makeNode(std::move(*first));
+        Node* chainLast = chainFirst;
+        for (std::size_t i = 1; i < count; ++i) {
+            ++first;
+            Node* node = makeNode(std::move(*first));
+            chainLast->next.store(node, std::memory_order_relaxed);
+            chainLast = node;
+        }
+        link(chainFirst, chainLast);
+    }
+
+    // Exact on the consumer thread. Other threads can see a stale answer,
+    // including, rarely, true while values were just enqueued.
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire)
+          == publishedTail.load(std::memory_order_acquire);
+    }
+
+    bool tryDequeue(T& value) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        value = std::move(*next->value());
+        NodeReleaser releaser;
+        advance(next, &releaser);
+        publishedTail.store(tail, std::memory_order_release);
+        return true;
+    }
+
+    // Moves at most maxCount values into the output iterator it, in order,
+    // and returns how many it moved.
+    template<class It>
+    std::size_t tryDequeueBulk(It it, std::size_t maxCount) {
+        NodeReleaser releaser;
+        std::size_t count = 0;
+        while (count < maxCount) {
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                break;
+            }
+            *it = std::move(*next->value());
+            ++it;
+            advance(next, &releaser);
+            count += 1;
+        }
+        if (count > 0) {
+            publishedTail.store(tail, std::memory_order_release);
+        }
+        return count;
+    }
+
+  private:
+    static void release(NodeBlock* block, std::size_t count) {
+        if (block->numLive.fetch_sub(count, std::memory_order_acq_rel)
+            == count) {
+            delete block;
+        }
+    }
+
+    static Node* allocateNode() {
+        static thread_local NodeAllocator allocator;
+        return allocator.allocate();
+    }
+
+    static Node* makeNode(T&& value) {
+        Node* node = allocateNode();
+        try {
+            ::new (static_cast<void*>(node->storage)) T(std::move(value));
+        } catch (...) {
+            release(node->block, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void link(Node* first, Node* last) {
+        Node* prev = head.exchange(last, std::memory_order_acq_rel);
+        prev->next.store(first, std::memory_order_release);
+    }
+
+    // The node holding the dequeued value becomes the new stub.
+    void advance(Node* next, NodeReleaser* releaser) {
+        std::destroy_at(next->value());
+        releaser->add(tail);
+        tail = next;
+    }
+
+    // Written by the producers.
+    alignas(kCacheLineSize) std::atomic<Node*> head = allocateNode();
+
+    // Written by the consumer. The queue is empty when the head is the tail.
+    alignas(kCacheLineSize) Node* tail = head.load(std::memory_order_relaxed);
+    std::atomic<Node*> publishedTail = tail;
+};
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "delayed_task.hpp"
+#include "delayed_task_inbox.hpp"
+#include "delayed_task_pool.hpp"
+
+namespace mcga::threading::base {
+
+// Same scheduling as DelayedQueueWrapper, but delayed tasks live in a per-loop
+// DelayedTaskPool instead of one std::make_shared allocation each, and the
+// heap orders plain (time point, node) pairs instead of dereferencing two
+// shared_ptrs per comparison. enqueueDelayed() and enqueueInterval() return a
+// generation-checked DelayedTaskPool::Handle instead of a shared_ptr.
+template<class Processor>
+class PooledDelayedQueueWrapper {
+  public:
+    using Task = typename Processor::Task;
+
+  private:
+    using Pool = DelayedTaskPool<Task>;
+    using Node = typename Pool::Node;
+
+  public:
+    using Clock = typename Pool::Clock;
+    using DelayedTaskPtr = typename Pool::Handle;
+    using Delay = typename Pool::Delay;
+
+    DelayedTaskPtr enqueueDelayed(Task task,
+                                  const Delay& delay,
+                                  const TimerOptions& options = {}) {
+        return enqueueDelayedTask(
+          pool.allocate(std::move(task), delay, false, options));
+    }
+
+    DelayedTaskPtr enqueueInterval(Task task,
+                                   const Delay& delay,
+                                   const TimerOptions& options = {}) {
+        return enqueueDelayedTask(
+          pool.allocate(std::move(task), delay, true, options));
+    }
+
+    // Cancelled tasks the loop did not drop yet.
+    std::size_t numDeadDelayedTasks() const {
+        return pool.numDeadNodes();
+    }
+
+    std::size_t numLiveDelayedTasks() const {
+        auto size = getDelayedQueueSize();
+        auto dead = numDeadDelayedTasks();
+        return size > dead ? size - dead : 0;
+    }
+
+  protected:
+    DelayedTaskPtr enqueueDelayedTask(Node* node) {
+        auto handle = pool.handleFor(node);
+        numDelayedTasks.fetch_add(1, std::memory_order_relaxed);
+        inbox.push(node);
+        return handle;
+    }
+
+    std::size_t getDelayedQueueSize() const {
+        return numDelayedTasks.load(std::memory_order_relaxed);
+    }
+
+    // The methods below must only be called from the loop thread, which owns
+    // the heap. Producers only ever touch the pool and the inbox. Like for
+    // DelayedQueueWrapper, the heap is ordered by the time point each task may
+    // run at the latest, but a task is popped as soon as it is due.
+
+    typename Clock::time_point getNextDelayedTimePoint() {
+        drainInbox();
+        return queue.empty() ? Clock::time_point::max()
+                             : queue.front().latestTimePoint;
+    }
+
+    Node* popDelayedQueue(const typename Clock::time_point& now) {
+        drainInbox();
+        if (queue.empty() || queue.front().node->timePoint > now) {
+            return nullptr;
+        }
+        std::pop_heap(queue.begin(), queue.end(), Compare());
+        Node* node = queue.back().node;
+        queue.pop_back();
+        return node;
+    }
+
+    bool executeDelayed(Processor* processor,
+                        const typename Clock::time_point& now) {
+        return executeDelayed(
+          processor, now, [](const auto& /*dueTimePoint*/, auto& /*task*/) {});
+    }
+
+    // Calls onExecute() with the time point the task was due at and the task,
+    // right before executing it.
+    template<class OnExecute>
+    bool executeDelayed(Processor* processor,
+                        const typename Clock::time_point& now,
+                        const OnExecute& onExecute) {
+        Node* node = this->popDelayedQueue(now);
+        if (node == nullptr) {
+            return false;
+        }
+        if (!node->isInterval()) {
+            if (node->finish()) {
+                onExecute(node->timePoint, node->task);
+                processor->executeTask(node->task);
+            }
+            numDelayedTasks.fetch_sub(1, std::memory_order_relaxed);
+            pool.release(node);
+            return true;
+        }
+        if (!node->isCancelled()) {
+            onExecute(node->timePoint, node->task);
+            processor->executeTask(node->task);
+        }
+        if (!node->isCancelled()) {
+            node->setNextTimePoint();
+            push(node);
+        } else {
+            numDelayedTasks.fetch_sub(1, std::memory_order_relaxed);
+            pool.release(node);
+        }
+        return true;
+    }
+
+  private:
+    struct Entry {
+        typename Clock::time_point latestTimePoint;
+        Node* node;
+    };
+
+    struct Compare {
+        inline bool operator()(const Entry& a, const Entry& b) const {
+            return a.latestTimePoint > b.latestTimePoint;
+        }
+    };
+
+    void push(Node* node) {
+        queue.push_back(Entry{node->latestTimePoint(), node});
+        std::push_heap(queue.begin(), queue.end(), Compare());
+    }
+
+    void drainInbox() {
+        inbox.drain([this](Node* node) {
+            push(node);
+        });
+        if (shouldCompactDelayedQueue(numDeadDelayedTasks(), queue.size())) {
+            compact();
+        }
+    }
+
+    // Releases all cancelled tasks in the heap at once.
+    void compact() {
+        auto dead = std::partition(
+          queue.begin(), queue.end(), [](const Entry& entry) {
+              return !entry.node->isCancelled();
+          });
+        for (auto it = dead; it != queue.end(); ++it) {
+            pool.release(it->node);
+        }
+        numDelayedTasks.fetch_sub(queue.end() - dead,
+                                  std::memory_order_relaxed);
+        queue.erase(dead, queue.end());
+        std::make_heap(queue.begin(), queue.end(), Compare());
+    }
+
+    Pool pool;
+    DelayedTaskInbox<Node*> inbox;
+    std::atomic_size_t numDelayedTasks = 0;
+    std::vector<Entry> queue;
+};
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <concurrentqueue.h>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+#include "dequeue_buffer.hpp"
+
+namespace mcga::threading::base {
+
+// The lane of a task in a PriorityImmediateQueueWrapper, higher is more
+// urgent. Levels past the last lane go to the last lane.
+struct Priority {
+    std::size_t level;
+
+    explicit Priority(std::size_t level): level(level) {
+    }
+};
+
+constexpr std::size_t kDefaultDrainRatio = 8;
+constexpr std::size_t kDefaultLowLaneBatchSize = 64;
+
+// Immediate queue with NumLanes priority lanes, so that urgent tasks (health
+// checks, cancellations...) do not wait behind a burst of ordinary ones.
+//
+// Every iteration, the loop takes one batch from the most urgent lane that
+// has tasks. To keep the other lanes from starving, a lane that has tasks but
+// was passed over for DrainRatio batches of more urgent lanes in a row gets
+// the next batch. Tasks enqueued without a priority go to the least urgent
+// lane (Priority(0)). Delayed tasks are not prioritized.
+//
+// A batch from any lane but the most urgent one holds at most
+// LowLaneBatchSize tasks, so an urgent task enqueued while the loop works
+// through a backlog of ordinary ones waits for at most that many of them.
+template<class Processor,
+         std::size_t NumLanes = 2,
+         std::size_t DrainRatio = kDefaultDrainRatio,
+         class BufferPolicy = DequeueBufferPolicy<>,
+         std::size_t LowLaneBatchSize = kDefaultLowLaneBatchSize>
+class PriorityImmediateQueueWrapper {
+    static_assert(NumLanes > 0, "A priority queue needs at least one lane.");
+    static_assert(DrainRatio > 0,
+                  "A drain ratio of 0 would always prefer less urgent lanes.");
+    static_assert(LowLaneBatchSize > 0,
+                  "A batch size of 0 would never drain the low lanes.");
+
+  public:
+    using Task = typename Processor::Task;
+
+    void enqueue(Task task) {
+        lanes[0].queue.enqueue(std::move(task));
+    }
+
+    void enqueue(Task task, Priority priority) {
+        laneFor(priority).queue.enqueue(std::move(task));
+    }
+
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        lanes[0].queue.enqueue_bulk(std::make_move_iterator(first), count);
+    }
+
+  protected:
+    std::size_t getImmediateQueueSize() const {
+        std::size_t size = buffer.size();
+        for (const Lane& lane: lanes) {
+            size += lane.queue.size_approx();
+        }
+        return size;
+    }
+
+    bool executeImmediate(Processor* processor) {
+        return executeImmediate(processor, [](std::size_t /*numDequeued*/) {});
+    }
+
+    // Calls onDequeued() with the number of tasks taken off the queue, before
+    // executing them.
+    template<class OnDequeued>
+    bool executeImmediate(Processor* processor, const OnDequeued& onDequeued) {
+        Lane* lane = pickLane();
+        std::size_t backlog = 0;
+        if (lane == &lanes[NumLanes - 1]) {
+            backlog = lane->queue.size_approx();
+        } else if (lane != nullptr) {
+            backlog = std::min(lane->queue.size_approx(), LowLaneBatchSize);
+        }
+        auto batchSize = buffer.reserve(backlog);
+        if (batchSize == 0) {
+            return false;
+        }
+        onDequeued(buffer.fill(batchSize, [lane](auto it, std::size_t count) {
+            return lane->queue.try_dequeue_bulk(lane->token, it, count);
+        }));
+        buffer.execute(processor);
+        return true;
+    }
+
+  private:
+    struct Lane {
+        moodycamel::ConcurrentQueue<Task> queue;
+        moodycamel::ConsumerToken token{queue};
+        // Batches taken from more urgent lanes while this one had tasks.
+        std::size_t numPassedOver = 0;
+    };
+
+    Lane& laneFor(Priority priority) {
+        return lanes[std::min(priority.level, NumLanes - 1)];
+    }
+
+    // Returns the lane to take the next batch from, or nullptr if all lanes
+    // are empty.
+    Lane* pickLane() {
+        Lane* mostUrgent = nullptr;
+        Lane* starved = nullptr;
+        for (std::size_t i = NumLanes; i-- > 0;) {
+            Lane& lane = lanes[i];
+            if (lane.queue.size_approx() == 0) {
+                lane.numPassedOver = 0;
+            } else if (mostUrgent == nullptr) {
+                mostUrgent = &lane;
+            } else if (++lane.numPassedOver > DrainRatio
+                       && starved == nullptr) {
+                starved = &lane;
+            }
+        }
+        Lane* picked = (starved != nullptr ? starved : mostUrgent);
+        if (picked != nullptr) {
+            picked->numPassedOver = 0;
+        }
+        return picked;
+    }
+
+    std::array<Lane, NumLanes> lanes;
+    DequeueBuffer<Task, BufferPolicy> buffer;
+};
+
+}  // namespace mcga::threading::base
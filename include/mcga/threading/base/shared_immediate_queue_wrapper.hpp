@@ -0,0 +1,85 @@
+#pragma once
+
+#include <concurrentqueue.h>
+
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "dequeue_buffer.hpp"
+
+namespace mcga::threading::base {
+
+// Immediate queue for the workers of a thread pool that all consume from a
+// single queue, each through its own consumer token. Tasks go to whichever
+// worker is free first, so there is no imbalance between workers, at the
+// price of all workers contending on the same queue.
+//
+// On its own (outside of a pool) it behaves like ImmediateQueueWrapper.
+template<class Processor, class BufferPolicy = DequeueBufferPolicy<>>
+class SharedImmediateQueueWrapper {
+  public:
+    using Task = typename Processor::Task;
+
+    void enqueue(Task task) {
+        queue->enqueue(std::move(task));
+    }
+
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        queue->enqueue_bulk(std::make_move_iterator(first), count);
+    }
+
+    // Called by ThreadPoolWrapper before the workers are started.
+    template<class Sibling>
+    void setSiblings(const std::vector<Sibling*>& workers) {
+        SharedImmediateQueueWrapper* owner = workers.front();
+        ownsQueue = (owner == this);
+        numConsumers = workers.size();
+        queueToken.reset();
+        queue = owner->queue;
+        queueToken = std::make_unique<moodycamel::ConsumerToken>(*queue);
+    }
+
+  protected:
+    std::size_t getImmediateQueueSize() const {
+        // Only one worker reports the shared queue, so that summing the sizes
+        // of all workers gives the size of the pool.
+        return (ownsQueue ? queue->size_approx() : 0) + buffer.size();
+    }
+
+    bool executeImmediate(Processor* processor) {
+        return executeImmediate(processor, [](std::size_t /*numDequeued*/) {});
+    }
+
+    // Calls onDequeued() with the number of tasks taken off the queue, before
+    // executing them.
+    template<class OnDequeued>
+    bool executeImmediate(Processor* processor, const OnDequeued& onDequeued) {
+        // Only take this worker's share of the queue, the other workers will
+        // take care of the rest.
+        auto queueSize = queue->size_approx();
+        auto batchSize
+          = buffer.reserve((queueSize + numConsumers - 1) / numConsumers);
+        if (batchSize == 0) {
+            return false;
+        }
+        onDequeued(buffer.fill(batchSize, [this](auto it, std::size_t count) {
+            return queue->try_dequeue_bulk(*queueToken, it, count);
+        }));
+        buffer.execute(processor);
+        return true;
+    }
+
+  private:
+    using Queue = moodycamel::ConcurrentQueue<Task>;
+
+    std::shared_ptr<Queue> queue = std::make_shared<Queue>();
+    std::unique_ptr<moodycamel::ConsumerToken> queueToken
+      = std::make_unique<moodycamel::ConsumerToken>(*queue);
+    bool ownsQueue = true;
+    std::size_t numConsumers = 1;
+    DequeueBuffer<Task, BufferPolicy> buffer;
+};
+
+}  // namespace mcga::threading::base
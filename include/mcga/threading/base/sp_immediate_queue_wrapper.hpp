@@ -1,16 +1,15 @@
 #pragma once
 
-#include <memory>
+#include <iterator>
 
 #include <concurrentqueue.h>
 
+#include "dequeue_buffer.hpp"
+
 namespace mcga::threading::base {
 
-template<class Processor>
+template<class Processor, class BufferPolicy = DequeueBufferPolicy<>>
 class SPImmediateQueueWrapper {
-  private:
-    static constexpr std::size_t kInitialBufferCapacity = 16;
-
   public:
     using Task = typename Processor::Task;
 
@@ -18,35 +17,47 @@ class SPImmediateQueueWrapper {
         queue.enqueue(queueProducerToken, std::move(task));
     }
 
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        queue.enqueue_bulk(
+          queueProducerToken, std::make_move_iterator(first), count);
+    }
+
   protected:
     std::size_t getImmediateQueueSize() const {
-        return queue.size_approx() + bufferSize;
+        return queue.size_approx() + buffer.size();
     }
 
     bool executeImmediate(Processor* processor) {
-        auto queueSize = queue.size_approx();
-        if (queueSize == 0) {
+        return executeImmediate(processor, [](std::size_t /*numDequeued*/) {});
+    }
+
+    // Calls onDequeued() with the number of tasks taken off the queue, before
+    // executing them.
+    template<class OnDequeued>
+    bool executeImmediate(Processor* processor, const OnDequeued& onDequeued) {
+        auto batchSize = buffer.reserve(queue.size_approx());
+        if (batchSize == 0) {
             return false;
         }
-        if (queueSize > bufferCapacity) {
-            bufferCapacity *= 2;
-            buffer = std::make_unique<Task[]>(bufferCapacity);
-        }
-        bufferSize = queue.try_dequeue_bulk(
-          queueConsumerToken, buffer.get(), bufferCapacity);
-        for (size_t i = 0; bufferSize > 0; --bufferSize, ++i) {
-            processor->executeTask(buffer[i]);
-        }
+        onDequeued(buffer.fill(batchSize, [this](auto it, std::size_t count) {
+            return queue.try_dequeue_bulk(queueConsumerToken, it, count);
+        }));
+        buffer.execute(processor);
         return true;
     }
 
+    // Takes the oldest task of one of the producers off the queue. Can be
+    // called from any thread, concurrently with the loop.
+    bool tryDequeue(Task& task) {
+        return queue.try_dequeue(task);
+    }
+
   private:
     moodycamel::ConcurrentQueue<Task> queue;
     moodycamel::ProducerToken queueProducerToken{queue};
     moodycamel::ConsumerToken queueConsumerToken{queue};
-    std::size_t bufferCapacity = kInitialBufferCapacity;
-    std::unique_ptr<Task[]> buffer = std::make_unique<Task[]>(bufferCapacity);
-    std::atomic_size_t bufferSize = 0;
+    DequeueBuffer<Task, BufferPolicy> buffer;
 };
 
 }  // namespace mcga::threading::base
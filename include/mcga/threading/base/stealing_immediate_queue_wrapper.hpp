@@ -0,0 +1,105 @@
+#pragma once
+
+#include <concurrentqueue.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "dequeue_buffer.hpp"
+
+namespace mcga::threading::base {
+
+// Immediate queue for the workers of a thread pool that, when it has nothing
+// left to execute, steals a batch of tasks from the queue of a busy sibling.
+//
+// Tasks are stolen in bulk from the victim's queue, and a stolen batch can mix
+// the tasks of several producers. Tasks from the same producer keep their
+// relative order within a batch, but can end up running concurrently on the
+// victim and the thief, or on two thieves.
+template<class Processor, class BufferPolicy = DequeueBufferPolicy<>>
+class StealingImmediateQueueWrapper {
+  private:
+    static constexpr std::size_t kMaxStealBatch = 256;
+
+  public:
+    using Task = typename Processor::Task;
+
+    void enqueue(Task task) {
+        queue.enqueue(std::move(task));
+    }
+
+    template<class It>
+    void enqueueBulk(It first, std::size_t count) {
+        queue.enqueue_bulk(std::make_move_iterator(first), count);
+    }
+
+    // Called by ThreadPoolWrapper before the workers are started.
+    template<class Sibling>
+    void setSiblings(const std::vector<Sibling*>& workers) {
+        siblings.clear();
+        for (Sibling* worker: workers) {
+            if (worker != this) {
+                siblings.push_back(worker);
+            }
+        }
+    }
+
+  protected:
+    std::size_t getImmediateQueueSize() const {
+        return queue.size_approx() + buffer.size();
+    }
+
+    bool executeImmediate(Processor* processor) {
+        return executeImmediate(processor, [](std::size_t /*numDequeued*/) {});
+    }
+
+    // Calls onDequeued() with the number of tasks taken off the queue or
+    // stolen, before executing them.
+    template<class OnDequeued>
+    bool executeImmediate(Processor* processor, const OnDequeued& onDequeued) {
+        auto batchSize = buffer.reserve(queue.size_approx());
+        if (batchSize == 0) {
+            return steal(processor, onDequeued);
+        }
+        onDequeued(buffer.fill(batchSize, [this](auto it, std::size_t count) {
+            return queue.try_dequeue_bulk(queueToken, it, count);
+        }));
+        buffer.execute(processor);
+        return true;
+    }
+
+  private:
+    template<class OnDequeued>
+    bool steal(Processor* processor, const OnDequeued& onDequeued) {
+        for (std::size_t i = 0; i < siblings.size(); ++i) {
+            nextVictim = (nextVictim + 1) % siblings.size();
+            StealingImmediateQueueWrapper* victim = siblings[nextVictim];
+            auto victimSize = victim->queue.size_approx();
+            if (victimSize == 0) {
+                continue;
+            }
+            // Take half of the victim's backlog, rounded up.
+            auto batchSize = buffer.reserve(
+              std::min((victimSize + 1) / 2, kMaxStealBatch));
+            auto numStolen
+              = buffer.fill(batchSize, [victim](auto it, std::size_t count) {
+                    return victim->queue.try_dequeue_bulk(it, count);
+                });
+            if (numStolen > 0) {
+                onDequeued(numStolen);
+                buffer.execute(processor);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    moodycamel::ConcurrentQueue<Task> queue;
+    moodycamel::ConsumerToken queueToken{queue};
+    DequeueBuffer<Task, BufferPolicy> buffer;
+    std::vector<StealingImmediateQueueWrapper*> siblings;
+    std::size_t nextVictim = 0;
+};
+
+}  // namespace mcga::threading::base
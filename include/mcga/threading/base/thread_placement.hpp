@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace mcga::threading::base {
+
+// Which CPUs the worker threads of a ThreadWrapper or ThreadPoolWrapper may
+// run on. Passed as the first constructor argument, before the processor's
+// arguments (after NumThreads for pools).
+//
+// Placement is only implemented on Linux. CPUs that do not exist or that the
+// process is not allowed to use are ignored by the kernel, but if none of a
+// worker's CPUs can be used, constructing or starting the wrapper throws
+// std::system_error. Elsewhere, any non-empty placement throws.
+class ThreadPlacement {
+  public:
+    // Every worker may run on any of the given CPUs.
+    static ThreadPlacement cpuSet(std::vector<int> cpus) {
+        return ThreadPlacement(std::move(cpus), false);
+    }
+
+    // Worker i only runs on cores[i % cores.size()].
+    static ThreadPlacement coreList(std::vector<int> cores) {
+        return ThreadPlacement(std::move(cores), true);
+    }
+
+    std::vector<int> cpusForWorker(std::size_t index) const {
+        if (!onePerWorker || cpus.empty()) {
+            return cpus;
+        }
+        return {cpus[index % cpus.size()]};
+    }
+
+  private:
+    ThreadPlacement(std::vector<int> cpus, bool onePerWorker)
+            : cpus(std::move(cpus)), onePerWorker(onePerWorker) {
+    }
+
+    std::vector<int> cpus;
+    bool onePerWorker;
+};
+
+// Restricts the calling thread to the given CPUs. Does nothing if cpus is
+// empty. Returns the reason the thread could not be pinned, if any.
+inline std::error_code pinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return {};
+    }
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu: cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    return {pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet),
+            std::system_category()};
+#else
+    return std::make_error_code(std::errc::function_not_supported);
+#endif
+}
+
+[[noreturn]] inline void throwPinError(std::error_code error) {
+    throw std::system_error(error, "cannot pin a worker thread to its CPUs");
+}
+
+// Runs func() on a short-lived thread pinned to the given CPUs, and returns
+// its result. Memory that func() allocates and writes to is first touched
+// from those CPUs, so under the default first-touch policy the kernel places
+// it on their NUMA node. Throws std::system_error if the thread cannot be
+// pinned.
+template<class Func>
+auto runOnCpus(const std::vector<int>& cpus, Func&& func) {
+    if (cpus.empty()) {
+        return func();
+    }
+    decltype(func()) result;
+    std::error_code error;
+    std::thread([&cpus, &func, &result, &error] {
+        error = pinCurrentThread(cpus);
+        if (!error) {
+            result = func();
+        }
+    }).join();
+    if (error) {
+        throwPinError(error);
+    }
+    return result;
+}
+
+}  // namespace mcga::threading::base
@@ -1,14 +1,21 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <thread>
+#include <vector>
 
+#include "thread_placement.hpp"
 #include "thread_wrapper.hpp"
+#include "worker_dispatch.hpp"
 
 namespace mcga::threading::base {
 
-template<class W, class Idx>
+template<class W,
+         class Idx,
+         class Dispatch = RoundRobinDispatch<Idx>,
+         class KeyDispatch = ModuloKeyDispatch>
 class ThreadPoolWrapper {
   private:
     using Thread = EmbeddedThreadWrapper<W>;
@@ -29,9 +36,30 @@ class ThreadPoolWrapper {
     explicit ThreadPoolWrapper(NumThreads numThreads, Args&&... args)
             : processor(std::forward<Args>(args)...) {
         threads.reserve(numThreads.numThreads);
-        for (int i = 0; i < numThreads.numThreads; i += 1) {
+        for (std::size_t i = 0; i < numThreads.numThreads; i += 1) {
             threads.push_back(std::make_unique<Thread>(&started, &processor));
         }
+        setSiblings();
+    }
+
+    template<class... Args>
+    explicit ThreadPoolWrapper(NumThreads numThreads,
+                               ThreadPlacement placement,
+                               Args&&... args)
+            : processor(std::forward<Args>(args)...) {
+        threads.reserve(numThreads.numThreads);
+        for (std::size_t i = 0; i < numThreads.numThreads; i += 1) {
+            threads.push_back(std::make_unique<Thread>(
+              &started, &processor, placement.cpusForWorker(i)));
+        }
+        setSiblings();
+    }
+
+    template<class... Args>
+    explicit ThreadPoolWrapper(ThreadPlacement placement, Args&&... args)
+            : ThreadPoolWrapper(NumThreads(std::thread::hardware_concurrency()),
+                                std::move(placement),
+                                std::forward<Args>(args)...) {
     }
 
     template<class... Args>
@@ -68,8 +96,18 @@ class ThreadPoolWrapper {
         }
         if (!started.load()) {
             started.store(true);
-            for (std::unique_ptr<Thread>& thread: threads) {
-                thread->start();
+            try {
+                for (std::unique_ptr<Thread>& thread: threads) {
+                    thread->start();
+                }
+            } catch (...) {
+                // Stops the workers started before the one that failed.
+                started.store(false);
+                for (std::unique_ptr<Thread>& thread: threads) {
+                    thread->stop();
+                }
+                isInStartOrStop.clear();
+                throw;
             }
         }
         isInStartOrStop.clear();
@@ -86,10 +124,43 @@ class ThreadPoolWrapper {
 
   protected:
     Wrapped* getWorker() {
-        return threads[(++currentThreadId) % threads.size()]->getWorker();
+        return threads[dispatch.select(threads)]->getWorker();
+    }
+
+    std::size_t getNumWorkers() const {
+        return threads.size();
+    }
+
+    template<class F>
+    void forEachWorker(const F& func) {
+        for (std::unique_ptr<Thread>& thread: threads) {
+            func(thread->getWorker());
+        }
+    }
+
+    template<class Key>
+    Wrapped* getWorkerForKey(const Key& key) {
+        return threads[keyDispatch.select(std::hash<Key>()(key),
+                                          threads.size())]
+          ->getWorker();
     }
 
   private:
+    void setSiblings() {
+        if constexpr (requires(W & w, const std::vector<W*>& workers) {
+                          w.setSiblings(workers);
+                      }) {
+            std::vector<W*> workers;
+            workers.reserve(threads.size());
+            for (std::unique_ptr<Thread>& thread: threads) {
+                workers.push_back(thread->getWorker());
+            }
+            for (W* worker: workers) {
+                worker->setSiblings(workers);
+            }
+        }
+    }
+
     void stopRaw() {
         while (isInStartOrStop.test_and_set()) {
             std::this_thread::yield();
@@ -103,7 +174,8 @@ class ThreadPoolWrapper {
     }
 
     Processor processor;
-    Idx currentThreadId = 0;
+    Dispatch dispatch;
+    KeyDispatch keyDispatch;
     std::atomic_flag isInStartOrStop = ATOMIC_FLAG_INIT;
     std::atomic_bool started = false;
     std::vector<std::unique_ptr<Thread>> threads;
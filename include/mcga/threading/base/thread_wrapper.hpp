@@ -1,7 +1,12 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <system_error>
 #include <thread>
+#include <vector>
+
+#include "thread_placement.hpp"
 
 namespace mcga::threading::base {
 
@@ -9,14 +14,40 @@ template<class W>
 class ThreadWrapperBase {
   public:
     std::size_t sizeApprox() const {
-        return worker.sizeApprox();
+        return worker->sizeApprox();
+    }
+
+    // Like sizeApprox(), but without the pending delayed tasks, which only
+    // load the worker once they are due.
+    std::size_t immediateQueueSize() const {
+        return worker->getImmediateQueueSize();
     }
 
   protected:
     using Processor = typename W::Processor;
 
+    // The worker (its event loop, queues and buffers included) is allocated
+    // from a thread already pinned to cpus, so its memory is first touched on
+    // the NUMA node it will run on.
+    explicit ThreadWrapperBase(std::vector<int> cpus = {})
+            : worker(runOnCpus(cpus,
+                               [] {
+                                   return std::make_unique<W>();
+                               })),
+              cpus(std::move(cpus)) {
+    }
+
     W* getWorker() {
-        return &worker;
+        return worker.get();
+    }
+
+    std::size_t getNumWorkers() const {
+        return 1;
+    }
+
+    template<class F>
+    void forEachWorker(const F& func) {
+        func(worker.get());
     }
 
     void acquireStartOrStop() {
@@ -29,30 +60,33 @@ class ThreadWrapperBase {
         isInStartOrStop.clear();
     }
 
+    // Both wait until the worker thread is pinned to its CPUs, and throw
+    // std::system_error, without running the worker, if it cannot be.
     void startThread(std::atomic_bool* started, Processor* processor) {
-        workerThread = std::thread([this, started, processor]() {
-            started->store(true);
-            this->worker.start(started, processor);
-        });
-        while (!started->load()) {
-            std::this_thread::yield();
-        }
+        launchThread(started, processor, true);
     }
 
     void startThreadEmbedded(std::atomic_bool* started, Processor* processor) {
-        std::atomic_bool localStarted = false;
-        this->workerThread
-          = std::thread([this, &localStarted, started, processor]() {
-                localStarted = true;
-                this->worker.start(started, processor);
-            });
-        while (!localStarted) {
-            std::this_thread::yield();
+        launchThread(started, processor, false);
+    }
+
+    // The worker might be parked waiting for work, make sure it sees that it
+    // was stopped.
+    void wakeToStop() {
+        if constexpr (requires { worker->wakeUp(); }) {
+            worker->wakeUp();
         }
     }
 
+    // Whether the worker thread returned from its loop, so joining it does
+    // not block.
+    bool hasThreadExited() const {
+        return threadExited.load();
+    }
+
     void tryJoin() {
         if (workerThread.joinable()) {
+            wakeToStop();
             // Since no other thread can enter start() or stop() while we are
             // here, nothing can happen that turns joinable() into
             // not-joinable() at this point (between the check and the join()).
@@ -60,9 +94,42 @@ class ThreadWrapperBase {
         }
     }
 
-    W worker;
+    std::unique_ptr<W> worker;
+    // The CPUs the worker thread is pinned to, empty for no pinning.
+    std::vector<int> cpus;
     std::thread workerThread;
     std::atomic_flag isInStartOrStop = ATOMIC_FLAG_INIT;
+    std::atomic_bool threadExited = false;
+
+  private:
+    void launchThread(std::atomic_bool* started,
+                      Processor* processor,
+                      bool markStarted) {
+        std::atomic_bool launched = false;
+        std::error_code error;
+        threadExited = false;
+        workerThread = std::thread(
+          [this, &launched, &error, started, processor, markStarted]() {
+              error = pinCurrentThread(cpus);
+              if (error) {
+                  launched = true;
+                  return;
+              }
+              if (markStarted) {
+                  started->store(true);
+              }
+              launched = true;
+              this->worker->start(started, processor);
+              threadExited = true;
+          });
+        while (!launched) {
+            std::this_thread::yield();
+        }
+        if (error) {
+            workerThread.join();
+            throwPinError(error);
+        }
+    }
 };
 
 template<class W>
@@ -77,6 +144,12 @@ class ThreadWrapper : public ThreadWrapperBase<W> {
             : started(false), processor(std::forward<Args>(args)...) {
     }
 
+    template<class... Args>
+    explicit ThreadWrapper(ThreadPlacement placement, Args&&... args)
+            : ThreadWrapperBase<W>(placement.cpusForWorker(0)), started(false),
+              processor(std::forward<Args>(args)...) {
+    }
+
     ThreadWrapper(const ThreadWrapper&) = delete;
     ThreadWrapper(ThreadWrapper&&) = delete;
 
@@ -93,8 +166,13 @@ class ThreadWrapper : public ThreadWrapperBase<W> {
 
     void start() {
         this->acquireStartOrStop();
-        if (!isRunning()) {
-            this->startThread(&started, &processor);
+        try {
+            if (!isRunning()) {
+                this->startThread(&started, &processor);
+            }
+        } catch (...) {
+            this->releaseStartOrStop();
+            throw;
         }
         this->releaseStartOrStop();
     }
@@ -127,8 +205,10 @@ class EmbeddedThreadWrapper : public ThreadWrapperBase<W> {
     using Task = typename W::Task;
 
     explicit EmbeddedThreadWrapper(std::atomic_bool* started,
-                                   Processor* processor)
-            : started(started), processor(processor) {
+                                   Processor* processor,
+                                   std::vector<int> cpus = {})
+            : ThreadWrapperBase<W>(std::move(cpus)), started(started),
+              processor(processor) {
     }
 
     EmbeddedThreadWrapper(const EmbeddedThreadWrapper&) = delete;
@@ -147,7 +227,12 @@ class EmbeddedThreadWrapper : public ThreadWrapperBase<W> {
 
     void start() {
         this->acquireStartOrStop();
-        this->startThreadEmbedded(started, processor);
+        try {
+            this->startThreadEmbedded(started, processor);
+        } catch (...) {
+            this->releaseStartOrStop();
+            throw;
+        }
         this->releaseStartOrStop();
     }
 
@@ -169,8 +254,11 @@ class EmbeddedThreadWrapper : public ThreadWrapperBase<W> {
     std::atomic_bool* started;
     Processor* processor;
 
-    template<class T, class I>
+    template<class T, class I, class D, class K>
     friend class ThreadPoolWrapper;
+
+    template<class T, class I, class D, class K>
+    friend class ElasticThreadPoolWrapper;
 };
 
 }  // namespace mcga::threading::base
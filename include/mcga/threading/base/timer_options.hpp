@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+
+namespace mcga::threading::base {
+
+// How an interval is re-armed after each run.
+enum class IntervalMode {
+    // The next run is due one period after the current one finished, so the
+    // schedule drifts by the task's execution time and the loop's latency.
+    kFixedDelay,
+    // Runs are due one period apart from the first one, whenever they
+    // actually ran. Runs the loop missed are executed back to back.
+    kFixedRate,
+    // Like kFixedRate, but runs the loop missed are skipped: the next run is
+    // the first one of the schedule that is not in the past.
+    kFixedRateSkipMissed,
+};
+
+// Per-timer options of enqueueDelayed() and enqueueInterval().
+struct TimerOptions {
+    IntervalMode mode = IntervalMode::kFixedDelay;
+
+    // How late the timer may run. The loop only wakes up for a timer when its
+    // slack ran out, and then also runs the other timers that are already
+    // due, so timers due around the same time share a wake-up. Must not be
+    // negative.
+    std::chrono::nanoseconds slack{0};
+};
+
+// The time point an interval with the given period is due at next, after its
+// run due at dueTimePoint finished at now.
+template<class TimePoint, class Period>
+TimePoint nextIntervalTimePoint(IntervalMode mode,
+                                const TimePoint& dueTimePoint,
+                                const Period& period,
+                                const TimePoint& now) {
+    using Duration = typename TimePoint::duration;
+    const auto step = std::chrono::duration_cast<Duration>(period);
+    if (mode == IntervalMode::kFixedDelay || step <= Duration::zero()) {
+        return now + step;
+    }
+    auto next = dueTimePoint + step;
+    if (mode == IntervalMode::kFixedRateSkipMissed && next < now) {
+        next += step * ((now - next) / step);
+        if (next < now) {
+            next += step;
+        }
+    }
+    return next;
+}
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "delayed_task.hpp"
+#include "delayed_task_inbox.hpp"
+
+namespace mcga::threading::base {
+
+// Hierarchical hashed timing wheel, a drop-in replacement for
+// DelayedQueueWrapper when a loop holds a large number of pending timers.
+//
+// Time is divided in ticks of duration Tick. The wheel has NumLevels levels
+// of 2^SlotBits slots each, a slot on level L covering 2^(L * SlotBits) ticks.
+// Inserting a task is O(1): it goes in the slot covering its due tick, on the
+// lowest level that can represent the distance to it. As time passes, slots
+// on higher levels are cascaded down. Cancelling a task is O(1) as well: the
+// task is only flagged, and is dropped the next time the wheel touches it, or
+// when cancelled tasks make up more than half of the wheel.
+//
+// Tasks are never executed before their delay has passed, but they can be
+// executed up to one Tick late, and tasks due during the same tick are
+// executed in insertion order. A task with a slack of at least one Tick goes
+// in the slot of a tick within its slack, rounded up to a multiple of the
+// largest power of two ticks that fits in it, so that nearby timers share a
+// slot and a wake-up. Like for DelayedQueueWrapper, producers hand
+// tasks over through an inbox and the wheel itself is only touched by the
+// loop thread.
+template<class Processor,
+         class Tick = std::chrono::milliseconds,
+         std::size_t SlotBits = 8,
+         std::size_t NumLevels = 4>
+class TimingWheelDelayedQueueWrapper {
+    static_assert(SlotBits > 0 && SlotBits * NumLevels < 64,
+                  "The wheel must be able to represent its range in 64 bits");
+
+  public:
+    using Task = typename Processor::Task;
+
+  private:
+    using DelayedTask = ::mcga::threading::base::DelayedTask<Task>;
+
+    static constexpr std::size_t kNumSlots = std::size_t{1} << SlotBits;
+    static constexpr std::uint64_t kSlotMask = kNumSlots - 1;
+
+  public:
+    using Clock = typename DelayedTask::Clock;
+    using DelayedTaskPtr = typename DelayedTask::DelayedTaskPtr;
+    using Delay = std::chrono::nanoseconds;
+
+    DelayedTaskPtr enqueueDelayed(Task task,
+                                  const Delay& delay,
+                                  const TimerOptions& options = {}) {
+        return enqueueDelayedTask(
+          DelayedTask::delayed(std::move(task), delay, options));
+    }
+
+    DelayedTaskPtr enqueueInterval(Task task,
+                                   const Delay& delay,
+                                   const TimerOptions& options = {}) {
+        return enqueueDelayedTask(
+          DelayedTask::interval(std::move(task), delay, options));
+    }
+
+    // Cancelled tasks the loop did not drop yet.
+    std::size_t numDeadDelayedTasks() const {
+        return numDead->load(std::memory_order_relaxed);
+    }
+
+    std::size_t numLiveDelayedTasks() const {
+        auto size = getDelayedQueueSize();
+        auto dead = numDeadDelayedTasks();
+        return size > dead ? size - dead : 0;
+    }
+
+  protected:
+    DelayedTaskPtr enqueueDelayedTask(DelayedTaskPtr delayedTask) {
+        delayedTask->numDead = numDead;
+        numDelayedTasks.fetch_add(1, std::memory_order_relaxed);
+        inbox.push(delayedTask);
+        return delayedTask;
+    }
+
+    std::size_t getDelayedQueueSize() const {
+        return numDelayedTasks.load(std::memory_order_relaxed);
+    }
+
+    // The methods below must only be called from the loop thread, which owns
+    // the wheel. Producers only ever touch the inbox.
+
+    typename Clock::time_point getNextDelayedTimePoint() {
+        drainInbox();
+        if (!ready.empty()) {
+            return startTime;
+        }
+        if (wheelSize == 0) {
+            return Clock::time_point::max();
+        }
+        // Earliest non-empty slot on the first level, or the moment the first
+        // level wraps around and the next slot of the second level cascades.
+        std::uint64_t tick = currentTick + 1;
+        for (; (tick & kSlotMask) != 0; ++tick) {
+            if (!levels[0][tick & kSlotMask].empty()) {
+                break;
+            }
+        }
+        return tickTimePoint(tick);
+    }
+
+    DelayedTaskPtr popDelayedQueue(const typename Clock::time_point& now) {
+        drainInbox();
+        if (ready.empty()) {
+            if (wheelSize == 0) {
+                return nullptr;
+            }
+            advance(now);
+            if (ready.empty()) {
+                return nullptr;
+            }
+        }
+        auto front = std::move(ready.front());
+        ready.pop_front();
+        return front;
+    }
+
+    bool executeDelayed(Processor* processor,
+                        const typename Clock::time_point& now) {
+        return executeDelayed(
+          processor, now, [](const auto& /*dueTimePoint*/, auto& /*task*/) {});
+    }
+
+    // Calls onExecute() with the time point the task was due at and the task,
+    // right before executing it.
+    template<class OnExecute>
+    bool executeDelayed(Processor* processor,
+                        const typename Clock::time_point& now,
+                        const OnExecute& onExecute) {
+        auto delayedTask = this->popDelayedQueue(now);
+        if (delayedTask == nullptr) {
+            return false;
+        }
+        if (!delayedTask->isCancelled()) {
+            onExecute(delayedTask->timePoint, delayedTask->task);
+            processor->executeTask(delayedTask->task);
+        }
+        if (!delayedTask->isCancelled() && delayedTask->isInterval()) {
+            delayedTask->setNextTimePoint();
+            insert(std::move(delayedTask));
+            return true;
+        }
+        if (!delayedTask->finish()) {
+            delayedTask->reclaim();
+        }
+        numDelayedTasks.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+  private:
+    using Slot = std::vector<DelayedTaskPtr>;
+    using Level = std::array<Slot, kNumSlots>;
+
+    static constexpr std::size_t levelShift(std::size_t level) {
+        return level * SlotBits;
+    }
+
+    std::uint64_t dueTick(const typename Clock::time_point& timePoint) const {
+        if (timePoint <= startTime) {
+            return 0;
+        }
+        return static_cast<std::uint64_t>(
+          std::chrono::ceil<Tick>(timePoint - startTime).count());
+    }
+
+    std::uint64_t dueTick(const DelayedTask& delayedTask) const {
+        const auto tick = dueTick(delayedTask.timePoint);
+        const auto slackTicks
+          = std::chrono::floor<Tick>(delayedTask.options.slack).count();
+        if (slackTicks <= 0) {
+            return tick;
+        }
+        const auto granularity
+          = std::bit_floor(static_cast<std::uint64_t>(slackTicks));
+        return (tick + granularity - 1) & ~(granularity - 1);
+    }
+
+    typename Clock::time_point tickTimePoint(std::uint64_t tick) const {
+        return startTime
+          + std::chrono::duration_cast<typename Clock::duration>(Tick(tick));
+    }
+
+    void insert(DelayedTaskPtr delayedTask) {
+        const auto tick = dueTick(*delayedTask);
+        if (tick <= currentTick) {
+            ready.push_back(std::move(delayedTask));
+            return;
+        }
+        for (std::size_t level = 0; level < NumLevels; ++level) {
+            if (((tick ^ currentTick) >> levelShift(level + 1)) == 0) {
+                auto slot = (tick >> levelShift(level)) & kSlotMask;
+                levels[level][slot].push_back(std::move(delayedTask));
+                wheelSize += 1;
+                return;
+            }
+        }
+        // Further away than the wheel can represent: park it in the last slot
+        // of the top level to be cascaded in this rotation, at which point it
+        // is re-inserted based on its real due tick.
+        auto slot = ((currentTick >> levelShift(NumLevels - 1)) + kSlotMask)
+          & kSlotMask;
+        levels[NumLevels - 1][slot].push_back(std::move(delayedTask));
+        wheelSize += 1;
+    }
+
+    void drainInbox() {
+        inbox.drain([this](DelayedTaskPtr delayedTask) {
+            if (wheelSize == 0) {
+                // Nothing to cascade, so catch up with the current time now
+                // instead of walking every elapsed tick on the next advance.
+                advance(Clock::now());
+            }
+            insert(std::move(delayedTask));
+        });
+        if (shouldCompactDelayedQueue(numDeadDelayedTasks(),
+                                      wheelSize + ready.size())) {
+            compact();
+        }
+    }
+
+    // Drops all cancelled tasks from the wheel at once.
+    template<class Container>
+    std::size_t compact(Container& tasks) {
+        auto dead = std::partition(
+          tasks.begin(), tasks.end(), [](const DelayedTaskPtr& delayedTask) {
+              return !delayedTask->isCancelled();
+          });
+        for (auto it = dead; it != tasks.end(); ++it) {
+            (*it)->reclaim();
+        }
+        std::size_t numDropped = tasks.end() - dead;
+        tasks.erase(dead, tasks.end());
+        return numDropped;
+    }
+
+    void compact() {
+        std::size_t numDropped = compact(ready);
+        for (Level& level: levels) {
+            for (Slot& slot: level) {
+                auto numDroppedFromSlot = compact(slot);
+                wheelSize -= numDroppedFromSlot;
+                numDropped += numDroppedFromSlot;
+            }
+        }
+        numDelayedTasks.fetch_sub(numDropped, std::memory_order_relaxed);
+    }
+
+    // The slot is swapped with cascading, which insert() can then refill,
+    // and both keep their storage, so cascading does not allocate once the
+    // slots grew to their usual size.
+    void cascade(std::size_t level, std::uint64_t tick) {
+        cascading.swap(levels[level][(tick >> levelShift(level)) & kSlotMask]);
+        wheelSize -= cascading.size();
+        for (DelayedTaskPtr& delayedTask: cascading) {
+            if (delayedTask->isCancelled()) {
+                delayedTask->reclaim();
+                numDelayedTasks.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+                insert(std::move(delayedTask));
+            }
+        }
+        cascading.clear();
+    }
+
+    void advance(const typename Clock::time_point& now) {
+        const auto nowTick = static_cast<std::uint64_t>(
+          std::chrono::floor<Tick>(now - startTime).count());
+        while (currentTick < nowTick) {
+            if (wheelSize == 0) {
+                currentTick = nowTick;
+                return;
+            }
+            currentTick += 1;
+            std::size_t topLevel = 0;
+            while (topLevel + 1 < NumLevels
+                   && (currentTick & ((std::uint64_t{1}
+                                       << levelShift(topLevel + 1))
+                                      - 1))
+                     == 0) {
+                topLevel += 1;
+            }
+            for (std::size_t level = topLevel; level > 0; --level) {
+                cascade(level, currentTick);
+            }
+            cascade(0, currentTick);
+        }
+    }
+
+    DelayedTaskInbox<DelayedTaskPtr> inbox;
+    std::atomic_size_t numDelayedTasks = 0;
+    // Shared with the tasks, since users can keep them past the loop.
+    std::shared_ptr<std::atomic_size_t> numDead
+      = std::make_shared<std::atomic_size_t>(0);
+    typename Clock::time_point startTime = Clock::now();
+    std::uint64_t currentTick = 0;
+    std::size_t wheelSize = 0;
+    std::array<Level, NumLevels> levels;
+    Slot cascading;
+    std::deque<DelayedTaskPtr> ready;
+};
+
+}  // namespace mcga::threading::base
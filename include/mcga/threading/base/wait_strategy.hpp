@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace mcga::threading::base {
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+// A wait strategy decides what an EventLoop does with its thread when an
+// iteration finds nothing to execute. The loop calls:
+//  - reset() after every iteration that executed something,
+//  - idle(shouldWake, nextDeadline) after every iteration that did not, where
+//    shouldWake() re-checks the immediate queue and the running flag and
+//    nextDeadline() returns the time point of the earliest delayed task (or
+//    Clock::time_point::max() if there is none). idle() returns whether it
+//    gave up the CPU, after which the loop reads the clock again for its
+//    timers,
+//  - notify() from producer threads after every enqueue, and when stopping.
+
+// Never gives up the CPU. Lowest latency, one full core per idle loop.
+class BusySpinWaitStrategy {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    void reset() {
+    }
+
+    template<class ShouldWake, class NextDeadline>
+    bool idle(const ShouldWake& /*shouldWake*/,
+              const NextDeadline& /*nextDeadline*/) {
+        cpuRelax();
+        return false;
+    }
+
+    void notify() {
+    }
+};
+
+// Spins for a while after the last executed task, then yields the CPU to
+// the scheduler on every idle iteration.
+template<std::size_t SpinIterations = 1024>
+class SpinThenYieldWaitStrategy {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    void reset() {
+        numIdleIterations = 0;
+    }
+
+    template<class ShouldWake, class NextDeadline>
+    bool idle(const ShouldWake& /*shouldWake*/,
+              const NextDeadline& /*nextDeadline*/) {
+        if (numIdleIterations < SpinIterations) {
+            numIdleIterations += 1;
+            cpuRelax();
+            return false;
+        }
+        std::this_thread::yield();
+        return true;
+    }
+
+    void notify() {
+    }
+
+  private:
+    std::size_t numIdleIterations = 0;
+};
+
+// Spins, then yields, then parks the thread on a condition variable until
+// either a producer enqueues something or the earliest delayed task is due.
+// Idle loops cost close to no CPU, at the price of a wake-up on the first
+// task enqueued after the loop parked.
+template<std::size_t SpinIterations = 1024, std::size_t YieldIterations = 64>
+class SpinThenParkWaitStrategy {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    void reset() {
+        numIdleIterations = 0;
+    }
+
+    template<class ShouldWake, class NextDeadline>
+    bool idle(const ShouldWake& shouldWake, const NextDeadline& nextDeadline) {
+        if (numIdleIterations < SpinIterations) {
+            numIdleIterations += 1;
+            cpuRelax();
+            return false;
+        }
+        if (numIdleIterations < SpinIterations + YieldIterations) {
+            numIdleIterations += 1;
+            std::this_thread::yield();
+            return true;
+        }
+        park(shouldWake, nextDeadline);
+        return true;
+    }
+
+    void notify() {
+        // Pairs with the fence in park(): either the loop sees the task we
+        // just enqueued when it re-checks its queues, or we see it parked.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard guard(parkLock);
+                signaled = true;
+            }
+            parkCondition.notify_one();
+        }
+    }
+
+  private:
+    template<class ShouldWake, class NextDeadline>
+    void park(const ShouldWake& shouldWake, const NextDeadline& nextDeadline) {
+        parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Clock::time_point deadline = nextDeadline();
+        if (!shouldWake() && deadline > Clock::now()) {
+            std::unique_lock lock(parkLock);
+            if (deadline == Clock::time_point::max()) {
+                parkCondition.wait(lock, [this] {
+                    return signaled;
+                });
+            } else {
+                parkCondition.wait_until(lock, deadline, [this] {
+                    return signaled;
+                });
+            }
+            signaled = false;
+        }
+        parked.store(false, std::memory_order_relaxed);
+    }
+
+    std::size_t numIdleIterations = 0;
+    std::atomic_bool parked = false;
+    std::mutex parkLock;
+    std::condition_variable parkCondition;
+    bool signaled = false;
+};
+
+using DefaultWaitStrategy = SpinThenParkWaitStrategy<>;
+
+}  // namespace mcga::threading::base
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace mcga::threading::base {
+
+// A dispatch policy picks the worker of a ThreadPoolWrapper that receives the
+// next task enqueued in the pool. select() gets the pool's threads and returns
+// the index of the chosen one. Load-aware policies compare the immediate queue
+// sizes of the workers, since pending timers do not keep a worker busy.
+
+// Cycles through the workers. Idx is the type of the counter, an atomic for
+// pools enqueued into from multiple threads and a plain integer otherwise.
+template<class Idx>
+class RoundRobinDispatch {
+  public:
+    template<class Threads>
+    std::size_t select(const Threads& threads) {
+        return (++currentThreadId) % threads.size();
+    }
+
+  private:
+    Idx currentThreadId = 0;
+};
+
+// Always picks the first worker, for pools whose workers all consume from one
+// shared queue, where it does not matter which worker a task is given to.
+class FirstWorkerDispatch {
+  public:
+    template<class Threads>
+    std::size_t select(const Threads& /*threads*/) {
+        return 0;
+    }
+};
+
+// Per producer thread state shared by the dispatch policies below, so that
+// producers never write to a cache line another producer also writes to.
+class ProducerLocalState {
+  public:
+    // Starts at a different value on every thread, so that producers do not
+    // all begin cycling from the first worker at the same time.
+    static std::size_t& counter() {
+        thread_local std::size_t value = seed();
+        return value;
+    }
+
+    // xorshift64, good enough to pick workers and cheap to advance.
+    static std::uint64_t random() {
+        thread_local std::uint64_t state = seed() | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+  private:
+    static std::uint64_t seed() {
+        return std::hash<std::thread::id>()(std::this_thread::get_id())
+          * 0x9E3779B97F4A7C15ULL;
+    }
+};
+
+// Cycles through the workers like RoundRobinDispatch, but every producer
+// thread keeps its own position, so there is no counter shared between them.
+class ThreadLocalRoundRobinDispatch {
+  public:
+    template<class Threads>
+    std::size_t select(const Threads& threads) {
+        return (++ProducerLocalState::counter()) % threads.size();
+    }
+};
+
+// Samples two distinct workers at random and picks the one with the shorter
+// queue. Reads two sizes per task instead of all of them, and still keeps the
+// longest queue within a small margin of the average under bursty load.
+class PowerOfTwoChoicesDispatch {
+  public:
+    template<class Threads>
+    std::size_t select(const Threads& threads) {
+        const std::size_t numThreads = threads.size();
+        if (numThreads < 2) {
+            return 0;
+        }
+        auto r = ProducerLocalState::random();
+        std::size_t first = (r >> 32) % numThreads;
+        std::size_t second = (r & 0xFFFFFFFFU) % (numThreads - 1);
+        if (second >= first) {
+            second += 1;
+        }
+        return threads[second]->immediateQueueSize()
+            < threads[first]->immediateQueueSize()
+          ? second
+          : first;
+    }
+};
+
+// Picks the worker with the shortest queue, stopping early at an idle one.
+// Reads the size of every worker, so it is best suited to small pools. The
+// scan starts at a different worker on every call, so that ties do not all
+// go to the same one.
+class LeastLoadedDispatch {
+  public:
+    template<class Threads>
+    std::size_t select(const Threads& threads) {
+        const std::size_t numThreads = threads.size();
+        const std::size_t start
+          = (++ProducerLocalState::counter()) % numThreads;
+        std::size_t best = start;
+        std::size_t bestSize = threads[best]->immediateQueueSize();
+        for (std::size_t i = 1; i < numThreads && bestSize > 0; ++i) {
+            std::size_t candidate = (start + i) % numThreads;
+            std::size_t size = threads[candidate]->immediateQueueSize();
+            if (size < bestSize) {
+                best = candidate;
+                bestSize = size;
+            }
+        }
+        return best;
+    }
+};
+
+// A key dispatch policy picks the worker of a ThreadPoolWrapper that receives
+// the tasks enqueued for a key. select() gets the std::hash of the key and the
+// number of workers, and must always return the same worker for the same
+// inputs, so tasks for one key all run on one thread, in enqueue order.
+
+// Mixes the bits of a std::hash value, which for integers is usually the
+// integer itself, so that keys sharing a stride still spread evenly.
+inline std::uint64_t mixKeyHash(std::uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+class ModuloKeyDispatch {
+  public:
+    std::size_t select(std::size_t keyHash, std::size_t numThreads) const {
+        return mixKeyHash(keyHash) % numThreads;
+    }
+};
+
+// Jump consistent hash (Lamping and Veach): when the number of workers goes
+// from n to n + 1, only 1 / (n + 1) of the keys move, all of them to the new
+// worker. Costs O(log n) per task and needs no lookup table.
+class ConsistentHashKeyDispatch {
+  public:
+    std::size_t select(std::size_t keyHash, std::size_t numThreads) const {
+        std::uint64_t key = mixKeyHash(keyHash);
+        std::int64_t bucket = -1;
+        std::int64_t next = 0;
+        while (next < static_cast<std::int64_t>(numThreads)) {
+            bucket = next;
+            key = key * 2862933555777941757ULL + 1;
+            next = static_cast<std::int64_t>(
+              static_cast<double>(bucket + 1)
+              * (static_cast<double>(1LL << 31)
+                 / static_cast<double>((key >> 33) + 1)));
+        }
+        return static_cast<std::size_t>(bucket);
+    }
+};
+
+}  // namespace mcga::threading::base
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mcga/threading/base/elastic_thread_pool_wrapper.hpp>
 #include <mcga/threading/base/event_loop.hpp>
 #include <mcga/threading/base/thread_pool_wrapper.hpp>
 #include <mcga/threading/base/thread_wrapper.hpp>
@@ -22,4 +23,140 @@ template<class Processor>
 using SPEventLoopThreadPoolConstruct = base::EventLoopConstruct<
   base::ThreadPoolWrapper<base::SPEventLoop<Processor>, std::size_t>>;
 
+// Every worker dequeues its immediate tasks from an MPSC linked queue, see
+// MPSCImmediateQueueWrapper.
+template<class Processor>
+using MPSCEventLoopThreadConstruct = base::EventLoopConstruct<
+  base::ThreadWrapper<base::MPSCEventLoop<Processor>>>;
+
+template<class Processor>
+using MPSCEventLoopThreadPoolConstruct = base::EventLoopConstruct<
+  base::ThreadPoolWrapper<base::MPSCEventLoop<Processor>,
+                          std::atomic_size_t>>;
+
+// Bounded variants: every worker holds at most Capacity immediate tasks, and
+// Overflow decides what happens to the tasks enqueued while it is full.
+template<class Processor,
+         std::size_t Capacity,
+         class Overflow = base::BlockOnOverflow>
+using BoundedEventLoopThreadConstruct = base::EventLoopConstruct<
+  base::ThreadWrapper<base::BoundedEventLoop<Processor, Capacity, Overflow>>>;
+
+template<class Processor,
+         std::size_t Capacity,
+         class Overflow = base::BlockOnOverflow>
+using BoundedSPEventLoopThreadConstruct
+  = base::EventLoopConstruct<base::ThreadWrapper<
+    base::BoundedSPEventLoop<Processor, Capacity, Overflow>>>;
+
+template<class Processor,
+         std::size_t Capacity,
+         class Overflow = base::BlockOnOverflow>
+using BoundedEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ThreadPoolWrapper<
+    base::BoundedEventLoop<Processor, Capacity, Overflow>,
+    std::atomic_size_t>>;
+
+template<class Processor,
+         std::size_t Capacity,
+         class Overflow = base::BlockOnOverflow>
+using BoundedSPEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ThreadPoolWrapper<
+    base::BoundedSPEventLoop<Processor, Capacity, Overflow>,
+    std::size_t>>;
+
+// Every worker keeps LoopMetrics, readable through stats().
+template<class Processor>
+using MeteredEventLoopThreadConstruct = base::EventLoopConstruct<
+  base::ThreadWrapper<base::MeteredEventLoop<Processor>>>;
+
+template<class Processor>
+using MeteredEventLoopThreadPoolConstruct = base::EventLoopConstruct<
+  base::ThreadPoolWrapper<base::MeteredEventLoop<Processor>,
+                          std::atomic_size_t>>;
+
+// Every worker records the latency of the tasks stamped by Processor, a
+// LatencyTrackingProcessor, readable through latencies().
+template<class Processor>
+using LatencyTrackedEventLoopThreadConstruct = base::EventLoopConstruct<
+  base::ThreadWrapper<base::LatencyTrackedEventLoop<Processor>>>;
+
+template<class Processor>
+using LatencyTrackedEventLoopThreadPoolConstruct = base::EventLoopConstruct<
+  base::ThreadPoolWrapper<base::LatencyTrackedEventLoop<Processor>,
+                          std::atomic_size_t>>;
+
+// Every worker drains NumLanes immediate lanes by priority, see
+// enqueue(task, Priority).
+template<class Processor,
+         std::size_t NumLanes = 2,
+         std::size_t DrainRatio = base::kDefaultDrainRatio>
+using PriorityEventLoopThreadConstruct
+  = base::EventLoopConstruct<base::ThreadWrapper<
+    base::PriorityEventLoop<Processor, NumLanes, DrainRatio>>>;
+
+template<class Processor,
+         std::size_t NumLanes = 2,
+         std::size_t DrainRatio = base::kDefaultDrainRatio>
+using PriorityEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ThreadPoolWrapper<
+    base::PriorityEventLoop<Processor, NumLanes, DrainRatio>,
+    std::atomic_size_t>>;
+
+// Every worker executes its immediate tasks earliest deadline first, see
+// enqueue(task, Deadline). Tasks enqueued without a deadline starve while
+// tasks with one keep coming.
+template<class Processor, class Late = base::ShedLateTasks>
+using DeadlineEventLoopThreadConstruct = base::EventLoopConstruct<
+  base::ThreadWrapper<base::DeadlineEventLoop<Processor, Late>>>;
+
+template<class Processor, class Late = base::ShedLateTasks>
+using DeadlineEventLoopThreadPoolConstruct = base::EventLoopConstruct<
+  base::ThreadPoolWrapper<base::DeadlineEventLoop<Processor, Late>,
+                          std::atomic_size_t>>;
+
+template<class Processor>
+using WorkStealingEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ThreadPoolWrapper<
+    base::WorkStealingEventLoop<Processor>,
+    std::atomic_size_t>>;
+
+// Each task goes to the less loaded of two workers sampled at random, and
+// producers do not share a dispatch counter.
+template<class Processor>
+using LoadBalancedEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ThreadPoolWrapper<
+    base::EventLoop<Processor>,
+    std::size_t,
+    base::PowerOfTwoChoicesDispatch>>;
+
+// Sends the tasks of a key to a worker picked by jump consistent hashing, so
+// going from n to n + 1 threads between runs only moves 1 / (n + 1) of the
+// keys, all to the new worker, e.g. for workers that cache per-key state.
+template<class Processor>
+using ConsistentHashEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ThreadPoolWrapper<
+    base::EventLoop<Processor>,
+    std::atomic_size_t,
+    base::RoundRobinDispatch<std::atomic_size_t>,
+    base::ConsistentHashKeyDispatch>>;
+
+// Runs between minThreads and maxThreads workers depending on load, see
+// ElasticPoolOptions.
+template<class Processor>
+using ElasticEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ElasticThreadPoolWrapper<
+    base::EventLoop<Processor>,
+    std::atomic_size_t>>;
+
+// All workers consume from one shared queue, so tasks are not dispatched
+// round-robin and enqueueing does not touch a shared counter. Delayed tasks
+// all go to the first worker.
+template<class Processor>
+using SharedQueueEventLoopThreadPoolConstruct
+  = base::EventLoopConstruct<base::ThreadPoolWrapper<
+    base::SharedQueueEventLoop<Processor>,
+    std::size_t,
+    base::FirstWorkerDispatch>>;
+
 }  // namespace mcga::threading::constructs
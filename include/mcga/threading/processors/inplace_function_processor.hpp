@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mcga::threading::processors {
+
+// With the vtable pointer, an InplaceFunction of the default capacity is 64
+// bytes, the size of a cache line. It is only aligned to max_align_t though,
+// so one that is not part of a cache-line-aligned buffer can straddle two.
+constexpr std::size_t kDefaultInplaceFunctionCapacity = 56;
+
+// Move-only, type-erased void() callable that stores the callable inline, in
+// Capacity bytes. Unlike std::function it never allocates: a callable that
+// does not fit is a compile error, not a heap fallback.
+template<std::size_t Capacity = kDefaultInplaceFunctionCapacity>
+class InplaceFunction {
+  public:
+    InplaceFunction() = default;
+
+    // Implicit, like std::function's, so enqueue() can take a lambda as is.
+    template<class F>
+    requires(!std::is_same_v<std::decay_t<F>, InplaceFunction>
+             && std::is_invocable_r_v<void, std::decay_t<F>&>)
+      InplaceFunction(F&& func) {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= Capacity,
+                      "Callable does not fit in the InplaceFunction, raise "
+                      "its Capacity.");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t),
+                      "Callable is over-aligned for an InplaceFunction.");
+        static_assert(std::is_nothrow_move_constructible_v<Callable>,
+                      "Callable must be nothrow move constructible.");
+        ::new (static_cast<void*>(storage)) Callable(std::forward<F>(func));
+        vtable = &kVTable<Callable>;
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+
+    InplaceFunction(InplaceFunction&& other) noexcept {
+        moveFrom(other);
+    }
+
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    ~InplaceFunction() {
+        reset();
+    }
+
+    explicit operator bool() const {
+        return vtable != nullptr;
+    }
+
+    // Throws std::bad_function_call if empty, like std::function.
+    void operator()() {
+        if (vtable == nullptr) {
+            throw std::bad_function_call();
+        }
+        vtable->invoke(storage);
+    }
+
+  private:
+    struct VTable {
+        void (*invoke)(void* callable);
+        void (*relocate)(void* from, void* to);
+        void (*destroy)(void* callable);
+    };
+
+    template<class Callable>
+    static constexpr VTable kVTable{
+      [](void* callable) {
+          (*static_cast<Callable*>(callable))();
+      },
+      [](void* from, void* to) {
+          auto* source = static_cast<Callable*>(from);
+          ::new (to) Callable(std::move(*source));
+          source->~Callable();
+      },
+      [](void* callable) {
+          static_cast<Callable*>(callable)->~Callable();
+      },
+    };
+
+    void moveFrom(InplaceFunction& other) {
+        if (other.vtable != nullptr) {
+            other.vtable->relocate(other.storage, storage);
+            vtable = other.vtable;
+            other.vtable = nullptr;
+        }
+    }
+
+    void reset() {
+        if (vtable != nullptr) {
+            vtable->destroy(storage);
+            vtable = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    const VTable* vtable = nullptr;
+};
+
+// Executes InplaceFunction tasks. Tasks can capture move-only state, and
+// enqueueing one never allocates for the callable itself.
+template<std::size_t Capacity = kDefaultInplaceFunctionCapacity>
+class InplaceFunctionProcessor {
+  public:
+    using Task = InplaceFunction<Capacity>;
+
+    static void executeTask(Task& task) {
+        task();
+    }
+};
+
+}  // namespace mcga::threading::processors
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <mcga/threading/base/latency_histogram.hpp>
+
+namespace mcga::threading::processors {
+
+constexpr std::size_t kDefaultLatencySampleEvery = 64;
+
+// A task of the wrapped processor, stamped with the time it was created at,
+// which is when it is enqueued. To keep enqueueing cheap, only one in every
+// SampleEvery tasks created by a thread is stamped, the others cost one
+// thread-local increment.
+template<class T, std::size_t SampleEvery>
+class StampedTask {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    StampedTask() = default;
+
+    // Implicit, so enqueue() takes whatever the wrapped Task is built from.
+    template<class F>
+    requires(!std::is_same_v<std::decay_t<F>, StampedTask>
+             && std::is_constructible_v<T, F>)
+      StampedTask(F&& task): task(std::forward<F>(task)) {
+        if (isNextSampled()) {
+            stamp = Clock::now();
+        }
+    }
+
+    bool isSampled() const {
+        return stamp != Clock::time_point();
+    }
+
+    Clock::time_point getStamp() const {
+        return stamp;
+    }
+
+    // Delayed tasks are restamped by the loop with the time point they were
+    // due at, so their queueing delay does not include the requested delay.
+    void restamp(const Clock::time_point& timePoint) {
+        if (isSampled()) {
+            stamp = timePoint;
+        }
+    }
+
+    T task;
+
+  private:
+    // Not in the constructor template, which would count the tasks of every
+    // callable type apart.
+    static bool isNextSampled() {
+        thread_local std::size_t numCreated = 0;
+        if (++numCreated == SampleEvery) {
+            numCreated = 0;
+            return true;
+        }
+        return false;
+    }
+
+    Clock::time_point stamp;
+};
+
+// Wraps processor P, recording the queueing delay and execution time of the
+// sampled tasks in the LatencyRecorder of the loop executing them. Only loops
+// with LatencyLoopMetrics have a recorder, elsewhere nothing is recorded.
+template<class P, std::size_t SampleEvery = kDefaultLatencySampleEvery>
+class LatencyTrackingProcessor {
+  public:
+    using Task = StampedTask<typename P::Task, SampleEvery>;
+    using Clock = typename Task::Clock;
+
+    template<class... Args>
+    explicit LatencyTrackingProcessor(Args&&... args)
+            : processor(std::forward<Args>(args)...) {
+    }
+
+    void executeTask(Task& task) {
+        base::LatencyRecorder* recorder = base::LatencyRecorder::current();
+        if (!task.isSampled() || recorder == nullptr) {
+            processor.executeTask(task.task);
+            return;
+        }
+        auto startTime = Clock::now();
+        processor.executeTask(task.task);
+        auto endTime = Clock::now();
+        recorder->record(startTime - task.getStamp(), endTime - startTime);
+    }
+
+  private:
+    P processor;
+};
+
+}  // namespace mcga::threading::processors
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <functional>
+#include <span>
+#include <tuple>
+
+namespace mcga::threading::processors {
+
+// Like ObjectProcessor, but the callback gets the objects of a whole batch as
+// one contiguous span, so it can run vectorized kernels over them. A batch is
+// what the loop took off its immediate queue in one go, delayed tasks come as
+// batches of one.
+template<class... Args>
+class ObjectBatchProcessor {
+  public:
+    using Task = std::tuple<Args...>;
+
+    explicit ObjectBatchProcessor(std::function<void(std::span<Task>)> func)
+            : func(func) {
+    }
+
+    void executeTask(Task& task) {
+        func(std::span<Task>(&task, 1));
+    }
+
+    void executeBatch(std::span<Task> batch) {
+        func(batch);
+    }
+
+  private:
+    std::function<void(std::span<Task>)> func;
+};
+
+template<class T>
+class ObjectBatchProcessor<T> {
+  public:
+    using Task = T;
+
+    explicit ObjectBatchProcessor(std::function<void(std::span<Task>)> func)
+            : func(func) {
+    }
+
+    void executeTask(Task& task) {
+        func(std::span<Task>(&task, 1));
+    }
+
+    void executeBatch(std::span<Task> batch) {
+        func(batch);
+    }
+
+  private:
+    std::function<void(std::span<Task>)> func;
+};
+
+}  // namespace mcga::threading::processors
@@ -0,0 +1,236 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isFalse;
+using mcga::matchers::isTrue;
+using mcga::threading::BlockOnOverflow;
+using mcga::threading::BoundedEventLoopThread;
+using mcga::threading::BoundedEventLoopThreadPool;
+using mcga::threading::BoundedSPEventLoopThread;
+using mcga::threading::DropNewestOnOverflow;
+using mcga::threading::DropOldestOnOverflow;
+using mcga::threading::FailOnOverflow;
+using mcga::threading::base::BoundedImmediateQueueWrapper;
+using mcga::threading::base::BusySpinWaitStrategy;
+using mcga::threading::base::DelayedQueueWrapper;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::processors::FunctionProcessor;
+
+namespace {
+
+// Keeps a worker busy until opened, so the tasks enqueued meanwhile pile up
+// in its queue.
+class Gate {
+  public:
+    std::function<void()> blockingTask() {
+        return [this] {
+            numBlocked += 1;
+            while (!open) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        };
+    }
+
+    void waitForBlocked(int numWorkers) {
+        while (numBlocked != numWorkers) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+
+    void release() {
+        open = true;
+    }
+
+  private:
+    std::atomic_int numBlocked = 0;
+    std::atomic_bool open = false;
+};
+
+// Records the ids of the executed tasks.
+class Recorder {
+  public:
+    std::function<void()> task(int id) {
+        return [this, id] {
+            std::lock_guard guard(lock);
+            ids.push_back(id);
+        };
+    }
+
+    void waitForSize(std::size_t size) {
+        while (getIds().size() != size) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+
+    std::vector<int> getIds() {
+        std::lock_guard guard(lock);
+        return ids;
+    }
+
+  private:
+    std::mutex lock;
+    std::vector<int> ids;
+};
+
+// Counts the times a loop was woken up.
+class CountingWaitStrategy : public BusySpinWaitStrategy {
+  public:
+    void notify() {
+        numNotified += 1;
+    }
+
+    static inline int numNotified = 0;
+};
+
+}  // namespace
+
+TEST_CASE("BoundedImmediateQueueWrapper") {
+    test("tryEnqueue fails once the queue is full", [&] {
+        Gate gate;
+        Recorder recorder;
+        BoundedEventLoopThread<4, FailOnOverflow> loop;
+        loop.start();
+        loop.enqueue(gate.blockingTask());
+        gate.waitForBlocked(1);
+        for (int i = 0; i < 4; ++i) {
+            expect(loop.tryEnqueue(recorder.task(i)), isTrue);
+        }
+        expect(loop.tryEnqueue(recorder.task(4)), isFalse);
+        loop.enqueue(recorder.task(5));
+        expect(loop.numRejectedTasks(), isEqualTo(2));
+        expect(loop.numDroppedTasks(), isEqualTo(0));
+        gate.release();
+        recorder.waitForSize(4);
+        loop.stop();
+        expect(recorder.getIds(), isEqualTo(std::vector<int>{0, 1, 2, 3}));
+    });
+
+    test("DropNewestOnOverflow drops the tasks enqueued while full", [&] {
+        Gate gate;
+        Recorder recorder;
+        BoundedEventLoopThread<4, DropNewestOnOverflow> loop;
+        loop.start();
+        loop.enqueue(gate.blockingTask());
+        gate.waitForBlocked(1);
+        for (int i = 0; i < 6; ++i) {
+            loop.enqueue(recorder.task(i));
+        }
+        expect(loop.numDroppedTasks(), isEqualTo(2));
+        gate.release();
+        recorder.waitForSize(4);
+        loop.stop();
+        expect(recorder.getIds(), isEqualTo(std::vector<int>{0, 1, 2, 3}));
+    });
+
+    test("DropOldestOnOverflow drops the oldest tasks to make room", [&] {
+        Gate gate;
+        Recorder recorder;
+        BoundedSPEventLoopThread<4, DropOldestOnOverflow> loop;
+        loop.start();
+        loop.enqueue(gate.blockingTask());
+        gate.waitForBlocked(1);
+        for (int i = 0; i < 6; ++i) {
+            loop.enqueue(recorder.task(i));
+        }
+        expect(loop.numDroppedTasks(), isEqualTo(2));
+        gate.release();
+        recorder.waitForSize(4);
+        loop.stop();
+        expect(recorder.getIds(), isEqualTo(std::vector<int>{2, 3, 4, 5}));
+    });
+
+    test("BlockOnOverflow blocks the producer until there is room", [&] {
+        Gate gate;
+        Recorder recorder;
+        BoundedEventLoopThread<2, BlockOnOverflow> loop;
+        loop.start();
+        loop.enqueue(gate.blockingTask());
+        gate.waitForBlocked(1);
+        loop.enqueue(recorder.task(0));
+        loop.enqueue(recorder.task(1));
+        expect(loop.tryEnqueueFor(recorder.task(2),
+                                  std::chrono::milliseconds{10}),
+               isFalse);
+
+        std::atomic_bool enqueued = false;
+        std::thread producer([&] {
+            loop.enqueue(recorder.task(3));
+            enqueued = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        expect(enqueued.load(), isFalse);
+        gate.release();
+        producer.join();
+        recorder.waitForSize(3);
+        loop.stop();
+        expect(recorder.getIds(), isEqualTo(std::vector<int>{0, 1, 3}));
+        expect(loop.numRejectedTasks(), isEqualTo(1));
+    });
+
+    test("Bulk enqueueing follows the overflow policy", [&] {
+        Gate gate;
+        Recorder recorder;
+        BoundedEventLoopThread<4, DropNewestOnOverflow> loop;
+        loop.start();
+        loop.enqueue(gate.blockingTask());
+        gate.waitForBlocked(1);
+        std::vector<std::function<void()>> tasks;
+        for (int i = 0; i < 10; ++i) {
+            tasks.push_back(recorder.task(i));
+        }
+        loop.enqueueBulk(tasks);
+        expect(loop.numDroppedTasks(), isEqualTo(6));
+        gate.release();
+        recorder.waitForSize(4);
+        loop.stop();
+        expect(recorder.getIds(), isEqualTo(std::vector<int>{0, 1, 2, 3}));
+    });
+
+    test("Tasks that did not go into the queue do not wake the loop", [&] {
+        // Not started, so nothing frees the two slots.
+        EventLoop<FunctionProcessor,
+                  BoundedImmediateQueueWrapper<
+                    ImmediateQueueWrapper<FunctionProcessor>,
+                    2,
+                    DropNewestOnOverflow>,
+                  DelayedQueueWrapper<FunctionProcessor>,
+                  CountingWaitStrategy>
+          loop;
+        CountingWaitStrategy::numNotified = 0;
+        for (int i = 0; i < 3; ++i) {
+            loop.enqueue([] {});
+        }
+        expect(CountingWaitStrategy::numNotified, isEqualTo(2));
+        std::vector<std::function<void()>> tasks(2, [] {});
+        loop.enqueueBulk(tasks.begin(), tasks.size());
+        expect(CountingWaitStrategy::numNotified, isEqualTo(2));
+        expect(loop.numDroppedTasks(), isEqualTo(3));
+    });
+
+    test("Pools bound every worker and sum their counters", [&] {
+        using Pool = BoundedEventLoopThreadPool<2, DropNewestOnOverflow>;
+        Gate gate;
+        Recorder recorder;
+        Pool pool(Pool::NumThreads(2));
+        pool.start();
+        pool.enqueue(gate.blockingTask());
+        pool.enqueue(gate.blockingTask());
+        gate.waitForBlocked(2);
+        for (int i = 0; i < 10; ++i) {
+            pool.enqueue(recorder.task(i));
+        }
+        expect(pool.numDroppedTasks(), isEqualTo(6));
+        gate.release();
+        recorder.waitForSize(4);
+        pool.stop();
+    });
+}
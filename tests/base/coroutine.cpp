@@ -0,0 +1,112 @@
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isTrue;
+using mcga::threading::CoTask;
+using mcga::threading::EventLoopThread;
+using mcga::threading::EventLoopThreadPool;
+using mcga::threading::InplaceEventLoopThread;
+using mcga::threading::syncWait;
+
+namespace {
+
+CoTask<std::thread::id> threadIdOn(EventLoopThread& loop) {
+    co_await loop.schedule();
+    co_return std::this_thread::get_id();
+}
+
+CoTask<int> add(EventLoopThread& loop, int a, int b) {
+    co_await loop.schedule();
+    co_return a + b;
+}
+
+CoTask<int> sumOfThree(EventLoopThread& loop, int a, int b, int c) {
+    int ab = co_await add(loop, a, b);
+    co_return co_await add(loop, ab, c);
+}
+
+CoTask<void> fail(EventLoopThread& loop) {
+    co_await loop.schedule();
+    throw std::runtime_error("failed");
+}
+
+}  // namespace
+
+TEST_CASE("Coroutines") {
+    test("schedule() resumes the coroutine on the loop", [&] {
+        EventLoopThread loop;
+        loop.start();
+        auto loopThread = syncWait(threadIdOn(loop));
+        expect(loopThread != std::this_thread::get_id(), isTrue);
+        expect(syncWait(threadIdOn(loop)) == loopThread, isTrue);
+        loop.stop();
+    });
+
+    test("A coroutine hops between loops", [&] {
+        EventLoopThread first;
+        EventLoopThread second;
+        first.start();
+        second.start();
+        auto hop = [&]() -> CoTask<bool> {
+            co_await first.schedule();
+            auto firstThread = std::this_thread::get_id();
+            co_await second.schedule();
+            co_return std::this_thread::get_id() != firstThread;
+        };
+        expect(syncWait(hop()), isTrue);
+        first.stop();
+        second.stop();
+    });
+
+    test("Tasks can await other tasks", [&] {
+        EventLoopThread loop;
+        loop.start();
+        expect(syncWait(sumOfThree(loop, 1, 2, 3)), isEqualTo(6));
+        loop.stop();
+    });
+
+    test("Exceptions propagate to the awaiting coroutine", [&] {
+        EventLoopThread loop;
+        loop.start();
+        bool caught = false;
+        try {
+            syncWait(fail(loop));
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        expect(caught, isTrue);
+        loop.stop();
+    });
+
+    test("sleepFor() resumes the coroutine after the delay", [&] {
+        EventLoopThreadPool pool(EventLoopThreadPool::NumThreads(2));
+        pool.start();
+        auto sleep = [&]() -> CoTask<std::chrono::nanoseconds> {
+            auto startTime = std::chrono::steady_clock::now();
+            co_await pool.sleepFor(std::chrono::milliseconds{20});
+            co_return std::chrono::steady_clock::now() - startTime;
+        };
+        expect(syncWait(sleep()) >= std::chrono::milliseconds{20}, isTrue);
+        pool.stop();
+    });
+
+    test("Coroutines work on loops with move-only tasks", [&] {
+        InplaceEventLoopThread<> loop;
+        loop.start();
+        auto produce = [&]() -> CoTask<std::unique_ptr<int>> {
+            co_await loop.schedule();
+            co_return std::make_unique<int>(7);
+        };
+        expect(*syncWait(produce()), isEqualTo(7));
+        loop.stop();
+    });
+}
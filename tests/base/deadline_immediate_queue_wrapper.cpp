@@ -0,0 +1,139 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isTrue;
+using mcga::threading::Deadline;
+using mcga::threading::DeadlineEventLoopThread;
+using mcga::threading::DeadlineEventLoopThreadPool;
+using mcga::threading::RunLateTasks;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace {
+
+void waitFor(const std::atomic_int& counter, int value) {
+    while (counter.load() < value) {
+        std::this_thread::sleep_for(milliseconds{1});
+    }
+}
+
+}  // namespace
+
+TEST_CASE("DeadlineImmediateQueueWrapper") {
+    test("Tasks run earliest deadline first", [&] {
+        DeadlineEventLoopThread<> loop;
+        std::string order;
+        std::atomic_int numExecuted = 0;
+        auto record = [&](char c) {
+            return [&order, &numExecuted, c] {
+                order += c;
+                numExecuted += 1;
+            };
+        };
+        auto now = Deadline::clock::now();
+        loop.enqueue(record('n'));
+        loop.enqueue(record('3'), now + seconds{3});
+        loop.enqueue(record('1'), now + seconds{1});
+        loop.enqueue(record('2'), now + seconds{2});
+        loop.enqueue(record('a'), now + seconds{2});
+        loop.start();
+        waitFor(numExecuted, 5);
+        loop.stop();
+        expect(order, isEqualTo(std::string("12a3n")));
+        expect(loop.numLateTasks(), isEqualTo(0UL));
+    });
+
+    test("Late tasks are shed and handed to the callback", [&] {
+        DeadlineEventLoopThread<> loop;
+        std::atomic_int numExecuted = 0;
+        std::atomic_int numShed = 0;
+        loop.setLateTaskCallback([&numShed](std::function<void()>& /*task*/,
+                                            Deadline /*deadline*/) {
+            numShed += 1;
+        });
+        auto now = Deadline::clock::now();
+        loop.enqueue(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          now - milliseconds{1});
+        loop.enqueue(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          now + seconds{10});
+        loop.start();
+        waitFor(numShed, 1);
+        waitFor(numExecuted, 1);
+        loop.stop();
+        expect(numExecuted.load(), isEqualTo(1));
+        expect(loop.numLateTasks(), isEqualTo(1UL));
+    });
+
+    test("RunLateTasks executes late tasks anyway", [&] {
+        DeadlineEventLoopThread<RunLateTasks> loop;
+        std::atomic_int numExecuted = 0;
+        loop.start();
+        loop.enqueue(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          Deadline::clock::now() - milliseconds{1});
+        waitFor(numExecuted, 1);
+        loop.stop();
+        expect(loop.numLateTasks(), isEqualTo(1UL));
+    });
+
+    test("Timers and deadline tasks share the loop", [&] {
+        DeadlineEventLoopThread<> loop;
+        std::atomic_int numExecuted = 0;
+        loop.start();
+        auto start = Deadline::clock::now();
+        loop.enqueueDelayed(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          milliseconds{20});
+        loop.enqueue(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          start + seconds{10});
+        waitFor(numExecuted, 2);
+        loop.stop();
+        expect(Deadline::clock::now() - start >= milliseconds{20}, isTrue);
+    });
+
+    test("Pools shed late tasks on all workers", [&] {
+        DeadlineEventLoopThreadPool<> pool(
+          DeadlineEventLoopThreadPool<>::NumThreads(4));
+        std::atomic_int numShed = 0;
+        pool.setLateTaskCallback(
+          [&numShed](std::function<void()>& /*task*/, Deadline /*deadline*/) {
+              numShed += 1;
+          });
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        auto now = Deadline::clock::now();
+        for (int i = 0; i < 100; ++i) {
+            pool.enqueue(
+              [&numExecuted] {
+                  numExecuted += 1;
+              },
+              i % 2 == 0 ? now - milliseconds{1} : now + seconds{10});
+        }
+        waitFor(numExecuted, 50);
+        waitFor(numShed, 50);
+        pool.stop();
+        expect(pool.numLateTasks(), isEqualTo(50UL));
+    });
+}
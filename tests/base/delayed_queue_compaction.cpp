@@ -0,0 +1,132 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isFalse;
+using mcga::matchers::isTrue;
+using mcga::threading::EventLoopThread;
+using mcga::threading::EventLoopThreadPool;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::base::kMinDeadDelayedTasksToCompact;
+using mcga::threading::base::PooledDelayedQueueWrapper;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::base::TimingWheelDelayedQueueWrapper;
+using mcga::threading::processors::FunctionProcessor;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace {
+
+template<template<class> class DelayedQueue>
+using LoopWith = EventLoopConstruct<
+  ThreadWrapper<EventLoop<FunctionProcessor,
+                          ImmediateQueueWrapper<FunctionProcessor>,
+                          DelayedQueue<FunctionProcessor>>>>;
+
+template<class Processor>
+using TimingWheel = TimingWheelDelayedQueueWrapper<Processor>;
+
+constexpr int kNumTasks = 200;
+constexpr int kNumCancelled = 150;
+
+// Cancels most of a backlog of far away timers that hold on to a resource,
+// and checks that the loop drops them without waiting for them to be due.
+template<class Loop>
+void expectCancelledTasksAreReclaimed() {
+    Loop loop;
+    auto resource = std::make_shared<int>(0);
+    std::vector<typename Loop::DelayedTaskPtr> tasks;
+    for (int i = 0; i < kNumTasks; ++i) {
+        tasks.push_back(loop.enqueueDelayed([resource] {}, seconds{60}));
+    }
+    for (int i = 0; i < kNumCancelled; ++i) {
+        tasks[i]->cancel();
+    }
+    expect(loop.numDeadDelayedTasks(),
+           isEqualTo(std::size_t{kNumCancelled}));
+    expect(loop.numLiveDelayedTasks(),
+           isEqualTo(std::size_t{kNumTasks - kNumCancelled}));
+
+    loop.start();
+    for (int i = 0; i < 1000 && loop.numDeadDelayedTasks() > 0; ++i) {
+        std::this_thread::sleep_for(milliseconds{1});
+    }
+    expect(loop.numDeadDelayedTasks(), isEqualTo(0UL));
+    expect(loop.numLiveDelayedTasks(),
+           isEqualTo(std::size_t{kNumTasks - kNumCancelled}));
+    expect(resource.use_count(), isEqualTo(1L + kNumTasks - kNumCancelled));
+    loop.stop();
+}
+
+}  // namespace
+
+TEST_CASE("Delayed queue compaction") {
+    test("DelayedQueueWrapper drops cancelled tasks", [&] {
+        expectCancelledTasksAreReclaimed<EventLoopThread>();
+    });
+
+    test("PooledDelayedQueueWrapper drops cancelled tasks", [&] {
+        expectCancelledTasksAreReclaimed<LoopWith<PooledDelayedQueueWrapper>>();
+    });
+
+    test("TimingWheelDelayedQueueWrapper drops cancelled tasks", [&] {
+        expectCancelledTasksAreReclaimed<LoopWith<TimingWheel>>();
+    });
+
+    test("A few cancelled tasks are left for the loop to skip", [&] {
+        EventLoopThread loop;
+        loop.start();
+        std::vector<EventLoopThread::DelayedTaskPtr> tasks;
+        for (std::size_t i = 0; i < kMinDeadDelayedTasksToCompact - 1; ++i) {
+            tasks.push_back(loop.enqueueDelayed([] {}, seconds{60}));
+            tasks.back()->cancel();
+        }
+        loop.enqueue([] {});
+        std::this_thread::sleep_for(milliseconds{20});
+        expect(loop.numDeadDelayedTasks(),
+               isEqualTo(kMinDeadDelayedTasksToCompact - 1));
+        expect(loop.numLiveDelayedTasks(), isEqualTo(0UL));
+        loop.stop();
+    });
+
+    test("Cancelling a finished task does not count it as dead", [&] {
+        EventLoopThread loop;
+        loop.start();
+        std::atomic_bool executed = false;
+        auto task = loop.enqueueDelayed(
+          [&executed] {
+              executed = true;
+          },
+          milliseconds{1});
+        while (!executed) {
+            std::this_thread::sleep_for(milliseconds{1});
+        }
+        std::this_thread::sleep_for(milliseconds{5});
+        expect(task->cancel(), isTrue);
+        expect(loop.numDeadDelayedTasks(), isEqualTo(0UL));
+        loop.stop();
+    });
+
+    test("Pools count dead tasks over all workers", [&] {
+        EventLoopThreadPool pool(EventLoopThreadPool::NumThreads(4));
+        std::vector<EventLoopThreadPool::DelayedTaskPtr> tasks;
+        for (int i = 0; i < 8; ++i) {
+            tasks.push_back(pool.enqueueDelayed([] {}, seconds{60}));
+        }
+        for (int i = 0; i < 6; ++i) {
+            expect(tasks[i]->cancel(), isFalse);
+        }
+        expect(pool.numDeadDelayedTasks(), isEqualTo(6UL));
+        expect(pool.numLiveDelayedTasks(), isEqualTo(2UL));
+    });
+}
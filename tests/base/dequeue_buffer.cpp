@@ -0,0 +1,153 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::threading::base::DequeueBuffer;
+using mcga::threading::base::DequeueBufferPolicy;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::processors::FunctionProcessor;
+
+namespace {
+
+using SmallPolicy = DequeueBufferPolicy<4, 64, 8>;
+
+// Moves tasks out of a vector, like a queue's try_dequeue_bulk().
+template<class Task>
+auto dequeueBulkFrom(std::vector<Task>& tasks) {
+    return [&tasks](auto it, std::size_t count) {
+        std::size_t numMoved = 0;
+        for (; numMoved < count && numMoved < tasks.size(); ++numMoved) {
+            *it++ = std::move(tasks[numMoved]);
+        }
+        tasks.erase(tasks.begin(), tasks.begin() + numMoved);
+        return numMoved;
+    };
+}
+
+struct ResourceProcessor {
+    using Task = std::shared_ptr<int>;
+
+    const Task* resource = nullptr;
+    std::vector<long> useCounts;
+
+    void executeTask(Task& /*task*/) {
+        useCounts.push_back(resource->use_count());
+    }
+};
+
+struct BatchProcessor {
+    using Task = int;
+
+    std::vector<std::vector<int>> batches;
+
+    void executeBatch(std::span<Task> batch) {
+        batches.emplace_back(batch.begin(), batch.end());
+    }
+};
+
+}  // namespace
+
+TEST_CASE("DequeueBuffer") {
+    test("Batches are capped at MaxBatchSize", [&] {
+        DequeueBuffer<int, SmallPolicy> buffer;
+        expect(buffer.getCapacity(), isEqualTo(4UL));
+        expect(buffer.reserve(1000), isEqualTo(64UL));
+        expect(buffer.getCapacity(), isEqualTo(64UL));
+    });
+
+    test("The buffer grows to fit the backlog", [&] {
+        DequeueBuffer<int, SmallPolicy> buffer;
+        expect(buffer.reserve(20), isEqualTo(20UL));
+        expect(buffer.getCapacity(), isEqualTo(32UL));
+    });
+
+    test("The buffer shrinks after ShrinkAfter low load iterations", [&] {
+        DequeueBuffer<int, SmallPolicy> buffer;
+        buffer.reserve(64);
+        for (int i = 0; i < 7; ++i) {
+            buffer.reserve(i % 2 == 0 ? 0 : 3);
+        }
+        expect(buffer.getCapacity(), isEqualTo(64UL));
+        buffer.reserve(0);
+        expect(buffer.getCapacity(), isEqualTo(8UL));
+    });
+
+    test("A busy iteration postpones shrinking", [&] {
+        DequeueBuffer<int, SmallPolicy> buffer;
+        buffer.reserve(64);
+        for (int i = 0; i < 7; ++i) {
+            buffer.reserve(0);
+        }
+        buffer.reserve(40);
+        for (int i = 0; i < 7; ++i) {
+            buffer.reserve(0);
+        }
+        expect(buffer.getCapacity(), isEqualTo(64UL));
+        buffer.reserve(0);
+        expect(buffer.getCapacity(), isEqualTo(4UL));
+    });
+
+    test("Every task is destroyed right after it is executed", [&] {
+        auto resource = std::make_shared<int>(0);
+        std::vector<std::shared_ptr<int>> queue{resource, resource, resource};
+        DequeueBuffer<std::shared_ptr<int>, SmallPolicy> buffer;
+        ResourceProcessor processor{&resource, {}};
+        auto batchSize = buffer.reserve(3);
+        expect(buffer.fill(batchSize, dequeueBulkFrom(queue)), isEqualTo(3UL));
+        expect(buffer.size(), isEqualTo(3UL));
+        buffer.execute(&processor);
+        expect(processor.useCounts, isEqualTo(std::vector<long>{4, 3, 2}));
+        expect(resource.use_count(), isEqualTo(1L));
+        expect(buffer.size(), isEqualTo(0UL));
+    });
+
+    test("Processors with executeBatch() get the batch in one call", [&] {
+        std::vector<int> queue{1, 2, 3, 4, 5};
+        DequeueBuffer<int, SmallPolicy> buffer;
+        BatchProcessor processor;
+        buffer.fill(buffer.reserve(5), dequeueBulkFrom(queue));
+        buffer.execute(&processor);
+        expect(processor.batches,
+               isEqualTo(std::vector<std::vector<int>>{{1, 2, 3, 4, 5}}));
+        expect(buffer.size(), isEqualTo(0UL));
+    });
+}
+
+TEST_CASE("DequeueBuffer in a loop") {
+    test("Tasks executed by a loop release their captures", [&] {
+        EventLoopConstruct<ThreadWrapper<EventLoop<
+          FunctionProcessor,
+          ImmediateQueueWrapper<FunctionProcessor, SmallPolicy>>>>
+          loop;
+        loop.start();
+        auto resource = std::make_shared<int>(0);
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 100; ++i) {
+            loop.enqueue([resource, &numExecuted] {
+                numExecuted += 1;
+            });
+        }
+        while (numExecuted < 100) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        // The loop is still running, but no task holds on to the resource
+        // once it was executed.
+        for (int i = 0; i < 1000 && resource.use_count() > 1; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        expect(resource.use_count(), isEqualTo(1L));
+        loop.stop();
+    });
+}
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::threading::ElasticEventLoopThreadPool;
+using mcga::threading::ElasticPoolOptions;
+using std::chrono::milliseconds;
+
+namespace {
+
+// Sustained load grows the pool within a few checks, and idle workers are
+// retired quickly.
+ElasticPoolOptions quickOptions() {
+    return ElasticPoolOptions{
+      .minThreads = 1,
+      .maxThreads = 4,
+      .growBacklog = 4,
+      .growAfter = milliseconds{2},
+      .idleTimeout = milliseconds{20},
+      .checkInterval = milliseconds{1},
+    };
+}
+
+template<class Condition>
+bool waitUntil(const Condition& condition) {
+    for (int i = 0; i < 5000 && !condition(); ++i) {
+        std::this_thread::sleep_for(milliseconds{1});
+    }
+    return condition();
+}
+
+}  // namespace
+
+TEST_CASE("ElasticThreadPoolWrapper") {
+    test("A pool starts with minThreads workers", [&] {
+        auto options = quickOptions();
+        options.minThreads = 2;
+        ElasticEventLoopThreadPool pool(options);
+        pool.start();
+        expect(pool.getNumActiveWorkers(), isEqualTo(2UL));
+        pool.stop();
+    });
+
+    test("Sustained backlog adds workers, up to maxThreads", [&] {
+        ElasticEventLoopThreadPool pool(quickOptions());
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 400; ++i) {
+            pool.enqueue([&numExecuted] {
+                std::this_thread::sleep_for(milliseconds{1});
+                numExecuted += 1;
+            });
+        }
+        std::size_t maxActiveWorkers = 0;
+        expect(waitUntil([&] {
+                   maxActiveWorkers = std::max(maxActiveWorkers,
+                                               pool.getNumActiveWorkers());
+                   return numExecuted == 400;
+               }),
+               isEqualTo(true));
+        expect(maxActiveWorkers, isEqualTo(4UL));
+        pool.stop();
+    });
+
+    test("An added worker takes part of the backlog", [&] {
+        auto options = quickOptions();
+        options.maxThreads = 2;
+        options.moveBacklogOnGrow = true;
+        ElasticEventLoopThreadPool pool(options);
+        pool.start();
+        std::atomic_bool blocking = false;
+        std::atomic_bool blocked = true;
+        pool.enqueue([&blocking, &blocked] {
+            blocking = true;
+            while (blocked) {
+                std::this_thread::sleep_for(milliseconds{1});
+            }
+        });
+        // So the tasks below stay queued instead of being dequeued along
+        // with this one.
+        waitUntil([&blocking] {
+            return blocking.load();
+        });
+        std::mutex lock;
+        std::set<std::thread::id> threads;
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 100; ++i) {
+            pool.enqueue([&] {
+                std::lock_guard guard(lock);
+                threads.insert(std::this_thread::get_id());
+                numExecuted += 1;
+            });
+        }
+        // Nothing is enqueued after the pool grows, so the second worker only
+        // executes tasks while the first one is blocked if it was handed some
+        // of its backlog.
+        expect(waitUntil([&numExecuted] {
+                   return numExecuted > 0;
+               }),
+               isEqualTo(true));
+        blocked = false;
+        expect(waitUntil([&numExecuted] {
+                   return numExecuted == 100;
+               }),
+               isEqualTo(true));
+        pool.stop();
+        expect(threads.size(), isEqualTo(2UL));
+    });
+
+    test("Keyed tasks stay in order while the pool grows", [&] {
+        ElasticEventLoopThreadPool pool(quickOptions());
+        pool.start();
+        std::atomic_bool blocking = false;
+        std::atomic_bool blocked = true;
+        pool.enqueue(0, [&blocking, &blocked] {
+            blocking = true;
+            while (blocked) {
+                std::this_thread::sleep_for(milliseconds{1});
+            }
+        });
+        waitUntil([&blocking] {
+            return blocking.load();
+        });
+        std::mutex lock;
+        std::vector<int> order;
+        std::set<std::thread::id> threads;
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 100; ++i) {
+            pool.enqueue(0, [&, i] {
+                std::lock_guard guard(lock);
+                order.push_back(i);
+                threads.insert(std::this_thread::get_id());
+                numExecuted += 1;
+            });
+        }
+        waitUntil([&pool] {
+            return pool.getNumActiveWorkers() > 1;
+        });
+        blocked = false;
+        expect(waitUntil([&numExecuted] {
+                   return numExecuted == 100;
+               }),
+               isEqualTo(true));
+        pool.stop();
+        expect(std::is_sorted(order.begin(), order.end()), isEqualTo(true));
+        expect(threads.size(), isEqualTo(1UL));
+    });
+
+    test("Idle workers are retired, down to minThreads", [&] {
+        ElasticEventLoopThreadPool pool(quickOptions());
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 400; ++i) {
+            pool.enqueue([&numExecuted] {
+                std::this_thread::sleep_for(milliseconds{1});
+                numExecuted += 1;
+            });
+        }
+        waitUntil([&pool] {
+            return pool.getNumActiveWorkers() > 1;
+        });
+        expect(waitUntil([&pool] {
+                   return pool.getNumActiveWorkers() == 1;
+               }),
+               isEqualTo(true));
+        expect(waitUntil([&numExecuted] {
+                   return numExecuted == 400;
+               }),
+               isEqualTo(true));
+        pool.stop();
+    });
+
+    test("No task is lost while workers come and go", [&] {
+        ElasticEventLoopThreadPool pool(quickOptions());
+        pool.start();
+        constexpr int numProducers = 4;
+        constexpr int numBursts = 20;
+        constexpr int burstSize = 50;
+        std::atomic_int numExecuted = 0;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < numProducers; ++p) {
+            producers.emplace_back([&pool, &numExecuted] {
+                for (int burst = 0; burst < numBursts; ++burst) {
+                    for (int i = 0; i < burstSize; ++i) {
+                        pool.enqueue([&numExecuted] {
+                            numExecuted += 1;
+                        });
+                    }
+                    // Long enough for the pool to retire some workers.
+                    std::this_thread::sleep_for(milliseconds{burst % 3 * 15});
+                }
+            });
+        }
+        for (std::thread& producer: producers) {
+            producer.join();
+        }
+        constexpr int numTasks = numProducers * numBursts * burstSize;
+        expect(waitUntil([&numExecuted] {
+                   return numExecuted == numTasks;
+               }),
+               isEqualTo(true));
+        pool.stop();
+    });
+
+    test("Delayed tasks run on a worker that is never retired", [&] {
+        ElasticEventLoopThreadPool pool(quickOptions());
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        pool.enqueueInterval(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          milliseconds{5});
+        for (int i = 0; i < 400; ++i) {
+            pool.enqueue([] {
+                std::this_thread::sleep_for(milliseconds{1});
+            });
+        }
+        waitUntil([&pool] {
+            return pool.getNumActiveWorkers() == 1 && pool.sizeApprox() == 1;
+        });
+        auto numExecutedWhenIdle = numExecuted.load();
+        expect(waitUntil([&numExecuted, numExecutedWhenIdle] {
+                   return numExecuted > numExecutedWhenIdle + 3;
+               }),
+               isEqualTo(true));
+        expect(pool.numLiveDelayedTasks(), isEqualTo(1UL));
+        pool.stop();
+    });
+
+    test("Stopping hands the tasks of extra workers to the others", [&] {
+        ElasticEventLoopThreadPool pool(quickOptions());
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        std::atomic_bool blocked = true;
+        for (int i = 0; i < 400; ++i) {
+            pool.enqueue([&numExecuted, &blocked] {
+                while (blocked) {
+                    std::this_thread::sleep_for(milliseconds{1});
+                }
+                numExecuted += 1;
+            });
+        }
+        waitUntil([&pool] {
+            return pool.getNumActiveWorkers() > 1;
+        });
+        blocked = false;
+        pool.stop();
+        expect(pool.getNumActiveWorkers(), isEqualTo(1UL));
+        expect(numExecuted + pool.sizeApprox(), isEqualTo(400UL));
+        pool.start();
+        expect(waitUntil([&numExecuted] {
+                   return numExecuted == 400;
+               }),
+               isEqualTo(true));
+        pool.stop();
+    });
+}
@@ -0,0 +1,231 @@
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isFalse;
+using mcga::matchers::isTrue;
+using mcga::threading::BoundedEventLoopThread;
+using mcga::threading::DropNewestOnOverflow;
+using mcga::threading::EventLoopThread;
+using mcga::threading::EventLoopThreadPool;
+using mcga::threading::Future;
+using mcga::threading::InplaceEventLoopThread;
+
+TEST_CASE("Future") {
+    test("submit returns the result of the task", [&] {
+        EventLoopThread loop;
+        loop.start();
+        Future<int> future = loop.submit([] {
+            return 42;
+        });
+        expect(future.get(), isEqualTo(42));
+        loop.stop();
+    });
+
+    test("A task returning void can be waited for", [&] {
+        EventLoopThread loop;
+        loop.start();
+        bool executed = false;
+        Future<void> future = loop.submit([&executed] {
+            executed = true;
+        });
+        future.get();
+        expect(executed, isTrue);
+        loop.stop();
+    });
+
+    test("A move-only result is moved out of the future", [&] {
+        EventLoopThreadPool pool(EventLoopThreadPool::NumThreads(2));
+        pool.start();
+        auto future = pool.submit([] {
+            return std::make_unique<std::string>("result");
+        });
+        expect(*future.get(), isEqualTo(std::string("result")));
+        pool.stop();
+    });
+
+    test("get() rethrows the exception thrown by the task", [&] {
+        EventLoopThread loop;
+        loop.start();
+        auto future = loop.submit([]() -> int {
+            throw std::runtime_error("failed");
+        });
+        bool caught = false;
+        try {
+            future.get();
+        } catch (const std::runtime_error& error) {
+            caught = (std::string(error.what()) == "failed");
+        }
+        expect(caught, isTrue);
+        loop.stop();
+    });
+
+    test("isReady() does not block", [&] {
+        EventLoopThread loop;
+        loop.start();
+        std::atomic_bool release = false;
+        auto future = loop.submit([&release] {
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+            return 1;
+        });
+        expect(future.isReady(), isFalse);
+        release = true;
+        future.wait();
+        expect(future.isReady(), isTrue);
+        expect(future.get(), isEqualTo(1));
+        loop.stop();
+    });
+
+    test("A future without a state throws no_state", [&] {
+        auto throwsNoState = [](const auto& call) {
+            try {
+                call();
+            } catch (const std::future_error& error) {
+                return error.code() == std::future_errc::no_state;
+            }
+            return false;
+        };
+        Future<int> empty;
+        expect(throwsNoState([&] {
+                   empty.isReady();
+               }),
+               isTrue);
+        EventLoopThread loop;
+        loop.start();
+        Future<int> consumed = loop.submit([] {
+            return 42;
+        });
+        consumed.get();
+        expect(consumed.isValid(), isFalse);
+        expect(throwsNoState([&] {
+                   consumed.wait();
+               }),
+               isTrue);
+        expect(throwsNoState([&] {
+                   consumed.get();
+               }),
+               isTrue);
+        loop.stop();
+    });
+
+    test("A continuation runs on the chosen loop", [&] {
+        EventLoopThread loop;
+        EventLoopThread otherLoop;
+        loop.start();
+        otherLoop.start();
+        auto otherLoopThread = otherLoop.submit([] {
+                                             return std::this_thread::get_id();
+                                         })
+                                 .get();
+        std::thread::id continuationThread;
+        auto future = loop.submit([] {
+                              return 20;
+                          })
+                        .then(otherLoop,
+                              [&continuationThread](int value) {
+                                  continuationThread
+                                    = std::this_thread::get_id();
+                                  return value + 1;
+                              })
+                        .then(loop, [](int value) {
+                            return value * 2;
+                        });
+        expect(future.get(), isEqualTo(42));
+        expect(continuationThread == otherLoopThread, isTrue);
+        loop.stop();
+        otherLoop.stop();
+    });
+
+    test("A continuation added after the result is ready still runs", [&] {
+        EventLoopThread loop;
+        loop.start();
+        auto future = loop.submit([] {
+            return 3;
+        });
+        future.wait();
+        auto next = future.then(loop, [](int value) {
+            return value * 3;
+        });
+        expect(next.get(), isEqualTo(9));
+        loop.stop();
+    });
+
+    test("An exception skips the continuations", [&] {
+        EventLoopThread loop;
+        loop.start();
+        bool continuationCalled = false;
+        auto future = loop.submit([]() -> int {
+                              throw std::runtime_error("failed");
+                          })
+                        .then(loop, [&continuationCalled](int value) {
+                            continuationCalled = true;
+                            return value;
+                        });
+        bool caught = false;
+        try {
+            future.get();
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        expect(caught, isTrue);
+        expect(continuationCalled, isFalse);
+        loop.stop();
+    });
+
+    test("A dropped task breaks its promise", [&] {
+        BoundedEventLoopThread<1, DropNewestOnOverflow> loop;
+        loop.start();
+        std::atomic_bool started = false;
+        std::atomic_bool release = false;
+        loop.enqueue([&] {
+            started = true;
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        });
+        while (!started) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        auto kept = loop.submit([] {
+            return 1;
+        });
+        auto dropped = loop.submit([] {
+            return 2;
+        });
+        expect(dropped.isReady(), isTrue);
+        bool broken = false;
+        try {
+            dropped.get();
+        } catch (const std::future_error& error) {
+            broken = (error.code() == std::future_errc::broken_promise);
+        }
+        expect(broken, isTrue);
+        release = true;
+        expect(kept.get(), isEqualTo(1));
+        loop.stop();
+    });
+
+    test("Futures work with move-only task types", [&] {
+        InplaceEventLoopThread<> loop;
+        loop.start();
+        auto future
+          = loop.submit([ptr = std::make_unique<int>(5)] {
+                    return *ptr;
+                }).then(loop, [](int value) {
+                return value + 1;
+            });
+        expect(future.get(), isEqualTo(6));
+        loop.stop();
+    });
+}
@@ -0,0 +1,194 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isTrue;
+using mcga::threading::LatencyHistogram;
+using mcga::threading::LatencyReport;
+using mcga::threading::LatencyStats;
+using mcga::threading::LatencyTrackedEventLoopThread;
+using mcga::threading::LatencyTrackedEventLoopThreadPool;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+
+namespace {
+
+void waitFor(const std::atomic_int& counter, int value) {
+    while (counter.load() < value) {
+        std::this_thread::sleep_for(milliseconds{1});
+    }
+}
+
+// Every instantiation enqueues a task of its own lambda type.
+template<int I, class Loop>
+void enqueueCounted(Loop& loop, std::atomic_int& numExecuted) {
+    loop.enqueue([&numExecuted] {
+        numExecuted += 1;
+    });
+}
+
+template<class Loop, int... Is>
+void enqueueDistinctTypes(Loop& loop,
+                          std::atomic_int& numExecuted,
+                          std::integer_sequence<int, Is...>) {
+    (enqueueCounted<Is>(loop, numExecuted), ...);
+}
+
+}  // namespace
+
+TEST_CASE("LatencyHistogram") {
+    test("Small values are exact", [&] {
+        LatencyHistogram histogram;
+        for (std::uint64_t value = 0; value < 16; ++value) {
+            histogram.record(value);
+        }
+        expect(histogram.count(), isEqualTo(16UL));
+        expect(histogram.percentile(50) == nanoseconds{7}, isTrue);
+        expect(histogram.max() == nanoseconds{15}, isTrue);
+    });
+
+    test("Bucket bounds are within the sub-bucket precision", [&] {
+        for (std::uint64_t value: {17UL, 100UL, 12345UL, 987654321UL}) {
+            auto bucket = LatencyHistogram::bucketFor(value);
+            auto upperBound = LatencyHistogram::bucketUpperBound(bucket);
+            expect(upperBound >= value, isTrue);
+            expect(upperBound - value <= value / 16, isTrue);
+            expect(LatencyHistogram::bucketFor(upperBound), isEqualTo(bucket));
+            expect(LatencyHistogram::bucketFor(upperBound + 1),
+                   isEqualTo(bucket + 1));
+        }
+    });
+
+    test("Percentiles of a uniform distribution", [&] {
+        LatencyHistogram histogram;
+        for (std::uint64_t value = 1; value <= 10000; ++value) {
+            histogram.record(value);
+        }
+        LatencyReport report = histogram.report();
+        expect(report.count, isEqualTo(10000UL));
+        expect(report.p50 >= nanoseconds{5000}, isTrue);
+        expect(report.p50 <= nanoseconds{5000 + 5000 / 16}, isTrue);
+        expect(report.p99 >= nanoseconds{9900}, isTrue);
+        expect(report.p999 >= nanoseconds{9990}, isTrue);
+        expect(report.max == nanoseconds{10000}, isTrue);
+    });
+
+    test("Merged histograms count the values of both", [&] {
+        LatencyHistogram low;
+        LatencyHistogram high;
+        for (int i = 0; i < 100; ++i) {
+            low.record(10);
+            high.record(1000000);
+        }
+        low += high;
+        expect(low.count(), isEqualTo(200UL));
+        expect(low.percentile(25) == nanoseconds{10}, isTrue);
+        expect(low.percentile(75) >= nanoseconds{1000000}, isTrue);
+        expect(low.max() == nanoseconds{1000000}, isTrue);
+    });
+
+    test("An empty histogram reports zeros", [&] {
+        LatencyReport report = LatencyHistogram().report();
+        expect(report.count, isEqualTo(0UL));
+        expect(report.p99 == nanoseconds{0}, isTrue);
+    });
+}
+
+TEST_CASE("Latency tracking") {
+    test("Only one in every SampleEvery tasks is recorded", [&] {
+        LatencyTrackedEventLoopThread<4> loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 100; ++i) {
+            loop.enqueue([&numExecuted] {
+                numExecuted += 1;
+            });
+        }
+        waitFor(numExecuted, 100);
+        loop.stop();
+        LatencyStats latencies = loop.latencies();
+        expect(latencies.queueingDelay.count(), isEqualTo(25UL));
+        expect(latencies.executionTime.count(), isEqualTo(25UL));
+        expect(loop.stats().immediateTasksDequeued, isEqualTo(100UL));
+    });
+
+    test("Tasks of different callable types are sampled together", [&] {
+        LatencyTrackedEventLoopThread<4> loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 3; ++i) {
+            enqueueDistinctTypes(
+              loop, numExecuted, std::make_integer_sequence<int, 12>());
+        }
+        waitFor(numExecuted, 36);
+        loop.stop();
+        expect(loop.latencies().queueingDelay.count(), isEqualTo(9UL));
+    });
+
+    test("Queueing delay includes the time spent behind other tasks", [&] {
+        LatencyTrackedEventLoopThread<1> loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        loop.enqueue([&numExecuted] {
+            std::this_thread::sleep_for(milliseconds{20});
+            numExecuted += 1;
+        });
+        loop.enqueue([&numExecuted] {
+            numExecuted += 1;
+        });
+        waitFor(numExecuted, 2);
+        loop.stop();
+        LatencyStats latencies = loop.latencies();
+        expect(latencies.queueingDelay.max() >= milliseconds{20}, isTrue);
+        expect(latencies.executionTime.max() >= milliseconds{20}, isTrue);
+    });
+
+    test("Delayed tasks are measured from when they were due", [&] {
+        LatencyTrackedEventLoopThread<1> loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        loop.enqueueDelayed(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          milliseconds{50});
+        waitFor(numExecuted, 1);
+        loop.stop();
+        LatencyStats latencies = loop.latencies();
+        expect(latencies.queueingDelay.count(), isEqualTo(1UL));
+        expect(latencies.queueingDelay.max() < milliseconds{50}, isTrue);
+    });
+
+    test("A pool merges the histograms of its workers", [&] {
+        LatencyTrackedEventLoopThreadPool<1> pool(
+          LatencyTrackedEventLoopThreadPool<1>::NumThreads(4));
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 200; ++i) {
+            pool.enqueue([&numExecuted] {
+                numExecuted += 1;
+            });
+        }
+        waitFor(numExecuted, 200);
+        pool.stop();
+        expect(pool.latencies().queueingDelay.count(), isEqualTo(200UL));
+    });
+
+    test("Futures work with stamped tasks", [&] {
+        LatencyTrackedEventLoopThread<1> loop;
+        loop.start();
+        expect(loop.submit([] {
+                       return 3;
+                   }).get(),
+               isEqualTo(3));
+        loop.stop();
+        expect(loop.latencies().executionTime.count(), isEqualTo(1UL));
+    });
+}
@@ -0,0 +1,161 @@
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isTrue;
+using mcga::threading::LoopStats;
+using mcga::threading::MeteredEventLoopThread;
+using mcga::threading::MeteredEventLoopThreadPool;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::Log2Histogram;
+using mcga::threading::base::NoLoopMetrics;
+using mcga::threading::processors::FunctionProcessor;
+
+namespace {
+
+template<std::size_t NumBuckets>
+std::uint64_t total(const Log2Histogram<NumBuckets>& histogram) {
+    return std::accumulate(
+      histogram.buckets.begin(), histogram.buckets.end(), std::uint64_t{0});
+}
+
+void waitFor(const std::atomic_int& counter, int value) {
+    while (counter.load() < value) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+}
+
+}  // namespace
+
+TEST_CASE("Loop metrics") {
+    test("Disabled metrics take no space in the loop", [&] {
+        using PlainLoop = EventLoop<FunctionProcessor>;
+        using NoMetricsLoop
+          = EventLoop<FunctionProcessor,
+                      mcga::threading::base::ImmediateQueueWrapper<
+                        FunctionProcessor>,
+                      mcga::threading::base::DelayedQueueWrapper<
+                        FunctionProcessor>,
+                      mcga::threading::base::DefaultWaitStrategy,
+                      NoLoopMetrics>;
+        expect(sizeof(PlainLoop) == sizeof(NoMetricsLoop), isTrue);
+    });
+
+    test("Log2Histogram buckets values by bit width", [&] {
+        using Histogram = Log2Histogram<4>;
+        expect(Histogram::bucketFor(0), isEqualTo(0UL));
+        expect(Histogram::bucketFor(1), isEqualTo(1UL));
+        expect(Histogram::bucketFor(2), isEqualTo(2UL));
+        expect(Histogram::bucketFor(3), isEqualTo(2UL));
+        expect(Histogram::bucketFor(4), isEqualTo(3UL));
+        expect(Histogram::bucketFor(1000), isEqualTo(3UL));
+    });
+
+    test("A loop counts the tasks it executes", [&] {
+        MeteredEventLoopThread loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 100; ++i) {
+            loop.enqueue([&numExecuted] {
+                numExecuted += 1;
+            });
+        }
+        waitFor(numExecuted, 100);
+        loop.stop();
+        LoopStats stats = loop.stats();
+        expect(stats.immediateTasksDequeued, isEqualTo(100UL));
+        expect(stats.delayedTasksExecuted, isEqualTo(0UL));
+        expect(total(stats.batchSizes) >= 1, isTrue);
+        expect(total(stats.batchSizes) <= 100, isTrue);
+        expect(stats.immediateQueueHighWaterMark <= 100, isTrue);
+    });
+
+    test("The high-water mark sees tasks piling up", [&] {
+        MeteredEventLoopThread loop;
+        loop.start();
+        std::atomic_bool blocking = false;
+        std::atomic_bool release = false;
+        std::atomic_int numExecuted = 0;
+        loop.enqueue([&] {
+            blocking = true;
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        });
+        // Otherwise the loop could take the tasks below in the same batch as
+        // this one, without seeing them queued at the start of an iteration.
+        while (!blocking) {
+            std::this_thread::yield();
+        }
+        std::vector<std::function<void()>> tasks(
+          50, [&numExecuted] {
+              numExecuted += 1;
+          });
+        loop.enqueueBulk(tasks);
+        release = true;
+        waitFor(numExecuted, 50);
+        loop.stop();
+        expect(loop.stats().immediateQueueHighWaterMark >= 50, isTrue);
+    });
+
+    test("Delayed tasks record how late they ran", [&] {
+        MeteredEventLoopThread loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 3; ++i) {
+            loop.enqueueDelayed(
+              [&numExecuted] {
+                  numExecuted += 1;
+              },
+              std::chrono::milliseconds{i});
+        }
+        waitFor(numExecuted, 3);
+        loop.stop();
+        LoopStats stats = loop.stats();
+        expect(stats.delayedTasksExecuted, isEqualTo(3UL));
+        expect(total(stats.timerLatenessUs), isEqualTo(3UL));
+    });
+
+    test("Busy and idle time add up", [&] {
+        MeteredEventLoopThread loop;
+        loop.start();
+        loop.enqueue([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        loop.stop();
+        LoopStats stats = loop.stats();
+        expect(stats.busyTime >= std::chrono::milliseconds{20}, isTrue);
+        expect(stats.idleTime > std::chrono::nanoseconds{0}, isTrue);
+    });
+
+    test("A pool aggregates the stats of its workers", [&] {
+        MeteredEventLoopThreadPool pool(
+          MeteredEventLoopThreadPool::NumThreads(4));
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 400; ++i) {
+            pool.enqueue([&numExecuted] {
+                numExecuted += 1;
+            });
+        }
+        pool.enqueueDelayed(
+          [&numExecuted] {
+              numExecuted += 1;
+          },
+          std::chrono::milliseconds{1});
+        waitFor(numExecuted, 401);
+        pool.stop();
+        LoopStats stats = pool.stats();
+        expect(stats.immediateTasksDequeued, isEqualTo(400UL));
+        expect(stats.delayedTasksExecuted, isEqualTo(1UL));
+    });
+}
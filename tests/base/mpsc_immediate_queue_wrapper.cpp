@@ -0,0 +1,123 @@
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::threading::MPSCEventLoopThread;
+using mcga::threading::MPSCEventLoopThreadPool;
+using mcga::threading::base::MPSCQueue;
+
+namespace {
+
+void waitFor(const std::atomic_int& counter, int value) {
+    while (counter.load() < value) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+}
+
+}  // namespace
+
+TEST_CASE("MPSCImmediateQueueWrapper") {
+    test("MPSCQueue dequeues the values of a producer in order", [&] {
+        MPSCQueue<int> queue;
+        for (int i = 0; i < 10; ++i) {
+            queue.enqueue(i);
+        }
+        expect(queue.isEmpty(), isEqualTo(false));
+        int value = -1;
+        expect(queue.tryDequeue(value), isEqualTo(true));
+        expect(value, isEqualTo(0));
+        std::vector<int> values;
+        expect(queue.tryDequeueBulk(std::back_inserter(values), 4),
+               isEqualTo(4UL));
+        expect(values, isEqualTo(std::vector<int>{1, 2, 3, 4}));
+        expect(queue.tryDequeueBulk(std::back_inserter(values), 100),
+               isEqualTo(5UL));
+        expect(values.back(), isEqualTo(9));
+        expect(queue.isEmpty(), isEqualTo(true));
+        expect(queue.tryDequeue(value), isEqualTo(false));
+    });
+
+    test("MPSCQueue enqueues a bulk of values in order", [&] {
+        MPSCQueue<int> queue;
+        queue.enqueue(0);
+        std::vector<int> bulk{1, 2, 3};
+        queue.enqueueBulk(bulk.begin(), bulk.size());
+        queue.enqueueBulk(bulk.begin(), 0);
+        queue.enqueue(4);
+        std::vector<int> values;
+        expect(queue.tryDequeueBulk(std::back_inserter(values), 100),
+               isEqualTo(5UL));
+        expect(values, isEqualTo(std::vector<int>{0, 1, 2, 3, 4}));
+    });
+
+    test("MPSCQueue destroys the values left in it", [&] {
+        auto value = std::make_shared<int>(0);
+        {
+            MPSCQueue<std::shared_ptr<int>> queue;
+            for (int i = 0; i < 3; ++i) {
+                queue.enqueue(value);
+            }
+            std::shared_ptr<int> dequeued;
+            queue.tryDequeue(dequeued);
+            expect(value.use_count(), isEqualTo(4L));
+        }
+        expect(value.use_count(), isEqualTo(1L));
+    });
+
+    test("No task is lost or reordered with many producers", [&] {
+        constexpr int numProducers = 8;
+        constexpr int numTasks = 10000;
+        MPSCEventLoopThread loop;
+        loop.start();
+        // Only touched by the loop thread.
+        std::vector<int> lastSeen(numProducers, -1);
+        std::atomic_int numOutOfOrder = 0;
+        std::atomic_int numExecuted = 0;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < numProducers; ++p) {
+            producers.emplace_back([&, p] {
+                for (int i = 0; i < numTasks; ++i) {
+                    loop.enqueue([&, p, i] {
+                        if (lastSeen[p] != i - 1) {
+                            numOutOfOrder += 1;
+                        }
+                        lastSeen[p] = i;
+                        numExecuted += 1;
+                    });
+                }
+            });
+        }
+        for (std::thread& producer: producers) {
+            producer.join();
+        }
+        waitFor(numExecuted, numProducers * numTasks);
+        loop.stop();
+        expect(numOutOfOrder.load(), isEqualTo(0));
+        expect(loop.sizeApprox(), isEqualTo(0UL));
+    });
+
+    test("A stopped loop keeps its tasks until it is started again", [&] {
+        MPSCEventLoopThreadPool pool(MPSCEventLoopThreadPool::NumThreads(4));
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 100; ++i) {
+            pool.enqueue([&numExecuted] {
+                numExecuted += 1;
+            });
+        }
+        // A worker counts its uncounted queue as a single task.
+        expect(pool.sizeApprox(), isEqualTo(4UL));
+        pool.start();
+        waitFor(numExecuted, 100);
+        pool.stop();
+        expect(pool.sizeApprox(), isEqualTo(0UL));
+    });
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <atomic>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading/base/event_loop.hpp>
+#include <mcga/threading/base/thread_wrapper.hpp>
+
+#include "../testing_utils/basic_processor.hpp"
+#include "../testing_utils/rand_utils.hpp"
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isFalse;
+using mcga::matchers::isTrue;
+using mcga::matchers::isZero;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::base::PooledDelayedQueueWrapper;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::testing::BasicProcessor;
+using mcga::threading::testing::randomDelay;
+
+using TestingProcessor = BasicProcessor<int>;
+
+using PooledLoop = EventLoopConstruct<
+  ThreadWrapper<EventLoop<TestingProcessor,
+                          ImmediateQueueWrapper<TestingProcessor>,
+                          PooledDelayedQueueWrapper<TestingProcessor>>>>;
+
+TEST_CASE("PooledDelayedQueueWrapper") {
+    std::unique_ptr<PooledLoop> loop;
+
+    setUp([&] {
+        loop = std::make_unique<PooledLoop>();
+        loop->start();
+    });
+
+    tearDown([&] {
+        loop->stop();
+        loop.reset();
+        TestingProcessor::reset();
+    });
+
+    test("Delayed executions are executed in the expected order", [&] {
+        loop->enqueueDelayed(1, std::chrono::milliseconds{100});
+        loop->enqueueDelayed(2, std::chrono::milliseconds{500});
+        loop->enqueueDelayed(3, std::chrono::milliseconds{400});
+        loop->enqueueDelayed(4, std::chrono::milliseconds{200});
+        loop->enqueueDelayed(5, std::chrono::milliseconds{300});
+
+        while (TestingProcessor::numProcessed() < 5) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        }
+        expect(TestingProcessor::objects,
+               isEqualTo(std::vector<int>{1, 4, 5, 3, 2}));
+    });
+
+    test("Cancelling a delayed invocation", [&] {
+        auto invocation
+          = loop->enqueueDelayed(1, std::chrono::milliseconds{5});
+        expect(invocation->cancel(), isFalse);
+        expect(invocation->cancel(), isTrue);
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        expect(TestingProcessor::numProcessed(), isZero);
+        expect(loop->sizeApprox(), isZero);
+    });
+
+    test("Cancelling an interval", [&] {
+        auto invocation
+          = loop->enqueueInterval(1, std::chrono::milliseconds{10});
+        while (TestingProcessor::numProcessed() < 3) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        invocation->cancel();
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        expect(TestingProcessor::numProcessed(), isEqualTo(3));
+    });
+
+    test("Cancelling a task while it executes fails", [&] {
+        PooledLoop::DelayedTaskPtr invocation;
+        std::atomic_bool enqueued = false;
+        std::atomic_bool cancelledWhileExecuting = false;
+        TestingProcessor::afterHandle = [&] {
+            while (!enqueued) {
+                std::this_thread::yield();
+            }
+            cancelledWhileExecuting = invocation->cancel();
+        };
+        invocation = loop->enqueueDelayed(1, std::chrono::milliseconds{1});
+        enqueued = true;
+        while (loop->sizeApprox() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        expect(cancelledWhileExecuting.load(), isTrue);
+        expect(loop->numDeadDelayedTasks(), isZero);
+    });
+
+    test("A handle to a finished task does not cancel the task reusing its "
+         "slot",
+         [&] {
+             auto finished
+               = loop->enqueueDelayed(1, std::chrono::milliseconds{1});
+             while (TestingProcessor::numProcessed() < 1) {
+                 std::this_thread::sleep_for(std::chrono::milliseconds{1});
+             }
+             std::this_thread::sleep_for(std::chrono::milliseconds{5});
+             loop->enqueueDelayed(2, std::chrono::milliseconds{5});
+             expect(finished->cancel(), isTrue);
+             while (TestingProcessor::numProcessed() < 2) {
+                 std::this_thread::sleep_for(std::chrono::milliseconds{1});
+             }
+             expect(TestingProcessor::objects,
+                    isEqualTo(std::vector<int>{1, 2}));
+         });
+
+    test("Enqueueing delayed executables from different threads", [&] {
+        constexpr int numWorkers = 20;
+        constexpr int numWorkerJobs = 1000;
+
+        std::vector<std::thread> workers;
+        workers.reserve(numWorkers);
+        for (int i = 0; i < numWorkers; ++i) {
+            workers.emplace_back([&loop, i] {
+                for (int j = 0; j < numWorkerJobs; ++j) {
+                    loop->enqueueDelayed(i * numWorkerJobs + j, randomDelay());
+                }
+            });
+        }
+        for (int i = 0; i < numWorkers; ++i) {
+            workers[i].join();
+        }
+        while (TestingProcessor::numProcessed() < numWorkers * numWorkerJobs) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        sort(TestingProcessor::objects.begin(),
+             TestingProcessor::objects.end());
+        for (int i = 0; i < numWorkers * numWorkerJobs; ++i) {
+            expect(TestingProcessor::objects[i], isEqualTo(i));
+        }
+    });
+}
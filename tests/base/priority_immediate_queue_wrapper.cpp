@@ -0,0 +1,162 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::threading::Priority;
+using mcga::threading::PriorityEventLoopThread;
+using mcga::threading::PriorityEventLoopThreadPool;
+using mcga::threading::base::DequeueBufferPolicy;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::kDefaultDrainRatio;
+using mcga::threading::base::PriorityImmediateQueueWrapper;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::processors::FunctionProcessor;
+
+namespace {
+
+// Takes one task per iteration, so that every batch is a single task.
+template<std::size_t NumLanes, std::size_t DrainRatio>
+using OneTaskPerBatchLoop = EventLoopConstruct<ThreadWrapper<
+  EventLoop<FunctionProcessor,
+            PriorityImmediateQueueWrapper<FunctionProcessor,
+                                          NumLanes,
+                                          DrainRatio,
+                                          DequeueBufferPolicy<1, 1, 1>>>>>;
+
+// Takes at most 2 tasks per batch from the ordinary lane.
+using SmallLowLaneBatchLoop = EventLoopConstruct<ThreadWrapper<
+  EventLoop<FunctionProcessor,
+            PriorityImmediateQueueWrapper<FunctionProcessor,
+                                          2,
+                                          kDefaultDrainRatio,
+                                          DequeueBufferPolicy<>,
+                                          2>>>>;
+
+void waitFor(const std::atomic_int& counter, int value) {
+    while (counter.load() < value) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+}
+
+}  // namespace
+
+TEST_CASE("PriorityImmediateQueueWrapper") {
+    test("Urgent tasks run before queued ordinary tasks", [&] {
+        PriorityEventLoopThread<> loop;
+        std::string order;
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 100; ++i) {
+            loop.enqueue([&] {
+                order += 'o';
+                numExecuted += 1;
+            });
+        }
+        loop.enqueue(
+          [&] {
+              order += 'U';
+              numExecuted += 1;
+          },
+          Priority(1));
+        loop.start();
+        waitFor(numExecuted, 101);
+        loop.stop();
+        expect(order.front(), isEqualTo('U'));
+    });
+
+    test("Waiting lanes get one batch every DrainRatio batches", [&] {
+        OneTaskPerBatchLoop<2, 2> loop;
+        std::string order;
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 3; ++i) {
+            loop.enqueue([&] {
+                order += 'o';
+                numExecuted += 1;
+            });
+        }
+        for (int i = 0; i < 9; ++i) {
+            loop.enqueue(
+              [&] {
+                  order += 'U';
+                  numExecuted += 1;
+              },
+              Priority(1));
+        }
+        loop.start();
+        waitFor(numExecuted, 12);
+        loop.stop();
+        expect(order, isEqualTo(std::string("UUoUUoUUoUUU")));
+    });
+
+    test("Lanes are drained from the most urgent one", [&] {
+        OneTaskPerBatchLoop<3, 100> loop;
+        std::string order;
+        std::atomic_int numExecuted = 0;
+        for (char lane: std::string("0120")) {
+            loop.enqueue(
+              [&order, &numExecuted, lane] {
+                  order += lane;
+                  numExecuted += 1;
+              },
+              Priority(lane - '0'));
+        }
+        // Past the last lane, like Priority(2).
+        loop.enqueue(
+          [&] {
+              order += '9';
+              numExecuted += 1;
+          },
+          Priority(9));
+        loop.start();
+        waitFor(numExecuted, 5);
+        loop.stop();
+        expect(order, isEqualTo(std::string("29100")));
+    });
+
+    test("Urgent tasks do not wait for a whole ordinary batch", [&] {
+        SmallLowLaneBatchLoop loop;
+        std::string order;
+        std::atomic_int numExecuted = 0;
+        auto urgent = [&] {
+            order += 'U';
+            numExecuted += 1;
+        };
+        for (int i = 0; i < 10; ++i) {
+            loop.enqueue([&, i] {
+                if (i == 0) {
+                    loop.enqueue(urgent, Priority(1));
+                }
+                order += 'o';
+                numExecuted += 1;
+            });
+        }
+        loop.start();
+        waitFor(numExecuted, 11);
+        loop.stop();
+        expect(order, isEqualTo(std::string("ooUoooooooo")));
+    });
+
+    test("Pools execute the tasks of all lanes", [&] {
+        PriorityEventLoopThreadPool<3> pool(
+          PriorityEventLoopThreadPool<3>::NumThreads(4));
+        pool.start();
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < 300; ++i) {
+            pool.enqueue(
+              [&numExecuted] {
+                  numExecuted += 1;
+              },
+              Priority(i % 3));
+        }
+        waitFor(numExecuted, 300);
+        pool.stop();
+        expect(numExecuted.load(), isEqualTo(300));
+    });
+}
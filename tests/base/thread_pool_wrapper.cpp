@@ -1,3 +1,5 @@
+#include <memory>
+#include <set>
 #include <vector>
 
 #include <mcga/test.hpp>
@@ -7,8 +9,15 @@
 
 #include "../testing_utils/rand_utils.hpp"
 
+using mcga::matchers::isEqualTo;
 using mcga::matchers::isFalse;
+using mcga::matchers::isNotEqualTo;
 using mcga::matchers::isTrue;
+using mcga::threading::base::ConsistentHashKeyDispatch;
+using mcga::threading::base::LeastLoadedDispatch;
+using mcga::threading::base::ModuloKeyDispatch;
+using mcga::threading::base::PowerOfTwoChoicesDispatch;
+using mcga::threading::base::ThreadLocalRoundRobinDispatch;
 using mcga::threading::base::ThreadPoolWrapper;
 using mcga::threading::testing::randomBool;
 
@@ -32,6 +41,28 @@ struct BasicWorker {
     }
 };
 
+struct FakeThread {
+    std::size_t size;
+    std::size_t numTimers = 0;
+
+    std::size_t sizeApprox() const {
+        return size + numTimers;
+    }
+
+    std::size_t immediateQueueSize() const {
+        return size;
+    }
+};
+
+std::vector<std::unique_ptr<FakeThread>>
+  makeThreads(const std::vector<std::size_t>& sizes) {
+    std::vector<std::unique_ptr<FakeThread>> threads;
+    for (std::size_t size: sizes) {
+        threads.push_back(std::make_unique<FakeThread>(FakeThread{size}));
+    }
+    return threads;
+}
+
 }  // namespace
 
 TEST_CASE("ThreadPoolWrapper") {
@@ -75,3 +106,94 @@ TEST_CASE("ThreadPoolWrapper") {
           }
       });
 }
+
+TEST_CASE("Worker dispatch") {
+    test("ThreadLocalRoundRobinDispatch cycles through all workers", [&] {
+        auto threads = makeThreads({0, 0, 0, 0, 0});
+        ThreadLocalRoundRobinDispatch dispatch;
+        std::set<std::size_t> selected;
+        for (std::size_t i = 0; i < threads.size(); ++i) {
+            selected.insert(dispatch.select(threads));
+        }
+        expect(selected.size(), isEqualTo(threads.size()));
+    });
+
+    test("PowerOfTwoChoicesDispatch picks the shorter of two queues", [&] {
+        auto threads = makeThreads({5, 2});
+        PowerOfTwoChoicesDispatch dispatch;
+        for (int i = 0; i < 100; ++i) {
+            expect(dispatch.select(threads), isEqualTo(1));
+        }
+    });
+
+    test("PowerOfTwoChoicesDispatch never picks the longest queue", [&] {
+        auto threads = makeThreads({3, 1, 9, 4, 0});
+        PowerOfTwoChoicesDispatch dispatch;
+        for (int i = 0; i < 1000; ++i) {
+            expect(dispatch.select(threads), isNotEqualTo(2));
+        }
+    });
+
+    test("LeastLoadedDispatch picks the shortest queue", [&] {
+        auto threads = makeThreads({3, 1, 9, 4, 2});
+        LeastLoadedDispatch dispatch;
+        for (int i = 0; i < 100; ++i) {
+            expect(dispatch.select(threads), isEqualTo(1));
+        }
+    });
+
+    test("Load-aware dispatch ignores pending timers", [&] {
+        auto threads = makeThreads({2, 1});
+        threads[1]->numTimers = 100;
+        PowerOfTwoChoicesDispatch powerOfTwoChoices;
+        LeastLoadedDispatch leastLoaded;
+        for (int i = 0; i < 100; ++i) {
+            expect(powerOfTwoChoices.select(threads), isEqualTo(1));
+            expect(leastLoaded.select(threads), isEqualTo(1));
+        }
+    });
+
+    test("LeastLoadedDispatch spreads ties between workers", [&] {
+        auto threads = makeThreads({0, 0, 0});
+        LeastLoadedDispatch dispatch;
+        std::set<std::size_t> selected;
+        for (std::size_t i = 0; i < threads.size(); ++i) {
+            selected.insert(dispatch.select(threads));
+        }
+        expect(selected.size(), isEqualTo(threads.size()));
+    });
+}
+
+TEST_CASE("Key dispatch") {
+    test("ModuloKeyDispatch spreads consecutive keys over all workers", [&] {
+        constexpr std::size_t numThreads = 8;
+        ModuloKeyDispatch dispatch;
+        std::vector<int> keysPerThread(numThreads, 0);
+        for (std::size_t key = 0; key < 8000; ++key) {
+            keysPerThread[dispatch.select(key, numThreads)] += 1;
+        }
+        for (int numKeys: keysPerThread) {
+            expect(numKeys > 800, isTrue);
+        }
+    });
+
+    test("ConsistentHashKeyDispatch only moves keys to a new worker", [&] {
+        constexpr std::size_t numKeys = 10000;
+        ConsistentHashKeyDispatch dispatch;
+        for (std::size_t numThreads = 1; numThreads < 16; ++numThreads) {
+            std::size_t numMoved = 0;
+            for (std::size_t key = 0; key < numKeys; ++key) {
+                auto before = dispatch.select(key, numThreads);
+                auto after = dispatch.select(key, numThreads + 1);
+                expect(before < numThreads, isTrue);
+                if (before != after) {
+                    expect(after, isEqualTo(numThreads));
+                    numMoved += 1;
+                }
+            }
+            // About numKeys / (numThreads + 1) keys should move.
+            expect(numMoved * (numThreads + 1) > numKeys / 2, isTrue);
+            expect(numMoved * (numThreads + 1) < numKeys * 2, isTrue);
+        }
+    });
+}
@@ -0,0 +1,169 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isGreaterThanEqual;
+using mcga::matchers::isLessThan;
+using mcga::threading::EventLoopThread;
+using mcga::threading::IntervalMode;
+using mcga::threading::TimerOptions;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::base::nextIntervalTimePoint;
+using mcga::threading::base::PooledDelayedQueueWrapper;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::base::TimingWheelDelayedQueueWrapper;
+using mcga::threading::processors::FunctionProcessor;
+using std::chrono::milliseconds;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<template<class> class DelayedQueue>
+using LoopWith = EventLoopConstruct<
+  ThreadWrapper<EventLoop<FunctionProcessor,
+                          ImmediateQueueWrapper<FunctionProcessor>,
+                          DelayedQueue<FunctionProcessor>>>>;
+
+template<class Processor>
+using TimingWheel = TimingWheelDelayedQueueWrapper<Processor>;
+
+void waitFor(const std::atomic_int& counter, int value) {
+    while (counter.load() < value) {
+        std::this_thread::sleep_for(milliseconds{1});
+    }
+}
+
+// A timer with a lot of slack is not woken up for on its own, but runs in the
+// wake-up of a later timer without slack.
+template<class Loop>
+void expectSlackCoalescesTimers() {
+    Loop loop;
+    std::mutex orderLock;
+    std::string order;
+    std::atomic_int numExecuted = 0;
+    auto record = [&](char c) {
+        return [&order, &orderLock, &numExecuted, c] {
+            std::lock_guard guard(orderLock);
+            order += c;
+            numExecuted += 1;
+        };
+    };
+    loop.start();
+    loop.enqueueDelayed(
+      record('a'), milliseconds{10}, TimerOptions{.slack = milliseconds{200}});
+    loop.enqueueDelayed(record('b'), milliseconds{50});
+    waitFor(numExecuted, 2);
+    loop.stop();
+    expect(order, isEqualTo(std::string("ba")));
+}
+
+}  // namespace
+
+TEST_CASE("TimerOptions") {
+    const auto due = Clock::time_point{} + milliseconds{100};
+    const auto period = milliseconds{10};
+
+    test("Fixed delay intervals are due one period after a run", [&] {
+        auto mode = IntervalMode::kFixedDelay;
+        auto now = due + milliseconds{25};
+        expect(nextIntervalTimePoint(mode, due, period, now),
+               isEqualTo(now + period));
+    });
+
+    test("Fixed rate intervals keep their schedule", [&] {
+        expect(nextIntervalTimePoint(
+                 IntervalMode::kFixedRate, due, period, due + milliseconds{3}),
+               isEqualTo(due + period));
+        // Missed runs are still due, so the loop catches up.
+        expect(nextIntervalTimePoint(
+                 IntervalMode::kFixedRate, due, period, due + milliseconds{35}),
+               isEqualTo(due + period));
+    });
+
+    test("Skipping missed runs resumes the schedule after now", [&] {
+        auto mode = IntervalMode::kFixedRateSkipMissed;
+        expect(nextIntervalTimePoint(mode, due, period, due + milliseconds{3}),
+               isEqualTo(due + period));
+        expect(nextIntervalTimePoint(mode, due, period, due + milliseconds{35}),
+               isEqualTo(due + milliseconds{40}));
+        expect(nextIntervalTimePoint(mode, due, period, due + milliseconds{40}),
+               isEqualTo(due + milliseconds{40}));
+    });
+
+    test("Fixed rate intervals do not drift by their execution time", [&] {
+        EventLoopThread loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        auto start = Clock::now();
+        auto interval = loop.enqueueInterval(
+          [&numExecuted] {
+              std::this_thread::sleep_for(milliseconds{10});
+              numExecuted += 1;
+          },
+          milliseconds{15},
+          TimerOptions{.mode = IntervalMode::kFixedRate});
+        waitFor(numExecuted, 10);
+        auto elapsed = Clock::now() - start;
+        interval->cancel();
+        loop.stop();
+        // 10 runs take 10 * (15 + 10)ms with a fixed delay.
+        expect(elapsed, isGreaterThanEqual(milliseconds{150}));
+        expect(elapsed, isLessThan(milliseconds{225}));
+    });
+
+    test("DelayedQueueWrapper coalesces timers with slack", [&] {
+        expectSlackCoalescesTimers<EventLoopThread>();
+    });
+
+    test("PooledDelayedQueueWrapper coalesces timers with slack", [&] {
+        expectSlackCoalescesTimers<LoopWith<PooledDelayedQueueWrapper>>();
+    });
+
+    test("TimingWheelDelayedQueueWrapper coalesces timers with slack", [&] {
+        expectSlackCoalescesTimers<LoopWith<TimingWheel>>();
+    });
+
+    test("A timer with slack is never executed before its delay", [&] {
+        EventLoopThread loop;
+        loop.start();
+        std::atomic_int numExecuted = 0;
+        auto start = Clock::now();
+        std::vector<Clock::duration> delays(3);
+        for (int i = 0; i < 3; ++i) {
+            loop.enqueueDelayed(
+              [&delays, &numExecuted, start, i] {
+                  delays[i] = Clock::now() - start;
+                  numExecuted += 1;
+              },
+              milliseconds{10 * (i + 1)},
+              TimerOptions{.slack = milliseconds{50}});
+        }
+        // Keeps the loop awake, so it runs the timers as soon as they are due.
+        std::atomic_bool running = true;
+        std::thread producer([&loop, &running] {
+            while (running) {
+                loop.enqueue([] {});
+                std::this_thread::sleep_for(milliseconds{1});
+            }
+        });
+        waitFor(numExecuted, 3);
+        running = false;
+        producer.join();
+        loop.stop();
+        for (int i = 0; i < 3; ++i) {
+            expect(delays[i], isGreaterThanEqual(milliseconds{10 * (i + 1)}));
+        }
+    });
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <atomic>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading/base/event_loop.hpp>
+#include <mcga/threading/base/thread_wrapper.hpp>
+
+#include "../testing_utils/basic_processor.hpp"
+#include "../testing_utils/rand_utils.hpp"
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isGreaterThanEqual;
+using mcga::matchers::isZero;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::base::TimingWheelDelayedQueueWrapper;
+using mcga::threading::testing::BasicProcessor;
+using mcga::threading::testing::randomDelay;
+
+using TestingProcessor = BasicProcessor<int>;
+
+template<class Tick = std::chrono::milliseconds,
+         std::size_t SlotBits = 8,
+         std::size_t NumLevels = 4>
+using TimingWheelLoop = EventLoopConstruct<ThreadWrapper<
+  EventLoop<TestingProcessor,
+            ImmediateQueueWrapper<TestingProcessor>,
+            TimingWheelDelayedQueueWrapper<TestingProcessor,
+                                           Tick,
+                                           SlotBits,
+                                           NumLevels>>>>;
+
+TEST_CASE("TimingWheelDelayedQueueWrapper") {
+    tearDown([&] {
+        TestingProcessor::reset();
+    });
+
+    test("Delayed executions are executed in the expected order", [&] {
+        TimingWheelLoop<> loop;
+        loop.start();
+        loop.enqueueDelayed(1, std::chrono::milliseconds{100});
+        loop.enqueueDelayed(2, std::chrono::milliseconds{500});
+        loop.enqueueDelayed(3, std::chrono::milliseconds{400});
+        loop.enqueueDelayed(4, std::chrono::milliseconds{200});
+        loop.enqueueDelayed(5, std::chrono::milliseconds{300});
+
+        while (TestingProcessor::numProcessed() < 5) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        }
+        loop.stop();
+        expect(TestingProcessor::objects,
+               isEqualTo(std::vector<int>{1, 4, 5, 3, 2}));
+    });
+
+    test("Delays beyond the range of the wheel are executed in order", [&] {
+        // 4 slots per level, 2 levels: the wheel covers 16 ticks of 1ms.
+        TimingWheelLoop<std::chrono::milliseconds, 2, 2> loop;
+        loop.start();
+        loop.enqueueDelayed(1, std::chrono::milliseconds{70});
+        loop.enqueueDelayed(2, std::chrono::milliseconds{5});
+        loop.enqueueDelayed(3, std::chrono::milliseconds{40});
+        loop.enqueueDelayed(4, std::chrono::milliseconds{12});
+
+        while (TestingProcessor::numProcessed() < 4) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        }
+        loop.stop();
+        expect(TestingProcessor::objects,
+               isEqualTo(std::vector<int>{2, 4, 3, 1}));
+    });
+
+    test("Cancelling a delayed invocation", [&] {
+        TimingWheelLoop<> loop;
+        loop.start();
+        auto invocation = loop.enqueueDelayed(1, std::chrono::milliseconds{5});
+        invocation->cancel();
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        loop.stop();
+        expect(TestingProcessor::numProcessed(), isZero);
+        expect(loop.sizeApprox(), isZero);
+    });
+
+    test("Enqueueing an executable interval executes it multiple times", [&] {
+        TimingWheelLoop<> loop;
+        loop.start();
+        auto invocation
+          = loop.enqueueInterval(1, std::chrono::milliseconds{10});
+        while (TestingProcessor::numProcessed() < 5) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        invocation->cancel();
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        loop.stop();
+        expect(TestingProcessor::numProcessed(), isEqualTo(5UL));
+    });
+
+    test("Enqueueing delayed executables from different threads", [&] {
+        constexpr int numWorkers = 20;
+        constexpr int numWorkerJobs = 1000;
+
+        TimingWheelLoop<std::chrono::microseconds> loop;
+        loop.start();
+        std::vector<std::thread> workers;
+        workers.reserve(numWorkers);
+        for (int i = 0; i < numWorkers; ++i) {
+            workers.emplace_back([&loop, i] {
+                for (int j = 0; j < numWorkerJobs; ++j) {
+                    loop.enqueueDelayed(i * numWorkerJobs + j, randomDelay());
+                }
+            });
+        }
+        for (int i = 0; i < numWorkers; ++i) {
+            workers[i].join();
+        }
+        while (TestingProcessor::numProcessed() < numWorkers * numWorkerJobs) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        loop.stop();
+        sort(TestingProcessor::objects.begin(),
+             TestingProcessor::objects.end());
+        for (int i = 0; i < numWorkers * numWorkerJobs; ++i) {
+            expect(TestingProcessor::objects[i], isEqualTo(i));
+        }
+    });
+
+    test("A delayed invocation is never executed before a period at least "
+         "equal to its delay has passed",
+         [&] {
+             TimingWheelLoop<> loop;
+             loop.start();
+             for (std::size_t i = 0; i < 50; ++i) {
+                 const auto expected = std::chrono::milliseconds{2};
+                 auto startTime = std::chrono::steady_clock::now();
+                 std::chrono::nanoseconds actual(0);
+                 // The processor counts the task as processed before calling
+                 // afterHandle, so wait for the measurement instead.
+                 std::atomic_bool measured = false;
+                 TestingProcessor::afterHandle = [&] {
+                     actual = std::chrono::steady_clock::now() - startTime;
+                     measured = true;
+                 };
+                 loop.enqueueDelayed(1, expected);
+                 while (!measured) {
+                     std::this_thread::sleep_for(std::chrono::microseconds{10});
+                 }
+                 expect(actual, isGreaterThanEqual(expected));
+             }
+             loop.stop();
+         });
+}
@@ -0,0 +1,98 @@
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading/base/event_loop.hpp>
+#include <mcga/threading/base/thread_wrapper.hpp>
+
+#include "../testing_utils/basic_processor.hpp"
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isFalse;
+using mcga::matchers::isGreaterThanEqual;
+using mcga::threading::base::BusySpinWaitStrategy;
+using mcga::threading::base::DelayedQueueWrapper;
+using mcga::threading::base::EventLoop;
+using mcga::threading::base::EventLoopConstruct;
+using mcga::threading::base::ImmediateQueueWrapper;
+using mcga::threading::base::SpinThenParkWaitStrategy;
+using mcga::threading::base::SpinThenYieldWaitStrategy;
+using mcga::threading::base::ThreadWrapper;
+using mcga::threading::testing::BasicProcessor;
+
+using TestingProcessor = BasicProcessor<int>;
+
+template<class WaitStrategy>
+using TestingLoop = EventLoopConstruct<
+  ThreadWrapper<EventLoop<TestingProcessor,
+                          ImmediateQueueWrapper<TestingProcessor>,
+                          DelayedQueueWrapper<TestingProcessor>,
+                          WaitStrategy>>>;
+
+// Parks right away, so every test below goes through the parked path.
+using ParkingLoop = TestingLoop<SpinThenParkWaitStrategy<0, 0>>;
+
+template<class Loop>
+void expectExecutesTasks() {
+    Loop loop;
+    loop.start();
+    loop.enqueue(1);
+    loop.enqueueDelayed(2, std::chrono::milliseconds{5});
+    while (TestingProcessor::numProcessed() < 2) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    loop.stop();
+    expect(TestingProcessor::objects, isEqualTo(std::vector<int>{1, 2}));
+    TestingProcessor::reset();
+}
+
+TEST_CASE("WaitStrategy") {
+    test("Loops execute tasks with every wait strategy", [&] {
+        expectExecutesTasks<TestingLoop<BusySpinWaitStrategy>>();
+        expectExecutesTasks<TestingLoop<SpinThenYieldWaitStrategy<>>>();
+        expectExecutesTasks<TestingLoop<SpinThenParkWaitStrategy<>>>();
+        expectExecutesTasks<ParkingLoop>();
+    });
+
+    test("A parked loop is woken up by enqueue", [&] {
+        ParkingLoop loop;
+        loop.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        for (std::size_t i = 0; i < 100; ++i) {
+            loop.enqueue(static_cast<int>(i));
+            while (TestingProcessor::numProcessed() < i + 1) {
+                std::this_thread::yield();
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+        }
+        loop.stop();
+        expect(TestingProcessor::numProcessed(), isEqualTo(100UL));
+        TestingProcessor::reset();
+    });
+
+    test("A parked loop wakes up when a delayed task is due", [&] {
+        ParkingLoop loop;
+        loop.start();
+        auto startTime = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds actual(0);
+        TestingProcessor::afterHandle = [&] {
+            actual = std::chrono::steady_clock::now() - startTime;
+        };
+        loop.enqueueDelayed(1, std::chrono::milliseconds{30});
+        while (TestingProcessor::numProcessed() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        loop.stop();
+        expect(actual, isGreaterThanEqual(std::chrono::milliseconds{30}));
+        TestingProcessor::reset();
+    });
+
+    test("A parked loop can be stopped", [&] {
+        ParkingLoop loop;
+        loop.start();
+        loop.enqueueDelayed(1, std::chrono::hours{1});
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        loop.stop();
+        expect(loop.isRunning(), isFalse);
+        TestingProcessor::reset();
+    });
+}
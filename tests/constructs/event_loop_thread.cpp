@@ -1,4 +1,7 @@
 #include <algorithm>
+#include <span>
+#include <system_error>
+#include <vector>
 
 #include <mcga/test.hpp>
 #include <mcga/test_ext/matchers.hpp>
@@ -7,6 +10,7 @@
 #include <mcga/threading/constructs.hpp>
 
 #include "../testing_utils/basic_processor.hpp"
+#include "../testing_utils/cpu_utils.hpp"
 #include "../testing_utils/rand_utils.hpp"
 
 using mcga::matchers::anyElement;
@@ -17,8 +21,13 @@ using mcga::matchers::isGreaterThanEqual;
 using mcga::matchers::isNotEqualTo;
 using mcga::matchers::isZero;
 using mcga::threading::base::EventLoop;
+using mcga::threading::base::ThreadPlacement;
 using mcga::threading::constructs::EventLoopThreadConstruct;
 using mcga::threading::testing::BasicProcessor;
+#if defined(__linux__)
+using mcga::threading::testing::firstAllowedCpu;
+using mcga::threading::testing::firstForbiddenCpu;
+#endif
 using mcga::threading::testing::randomDelay;
 
 using TestingProcessor = BasicProcessor<int>;
@@ -91,6 +100,20 @@ TEST_CASE("EventLoopThread") {
         expect(TestingProcessor::objects[0], isEqualTo(task));
     });
 
+    test("Enqueueing executables in bulk executes them in order", [&] {
+        constexpr int numTasks = 1000;
+        std::vector<int> tasks(numTasks);
+        for (int i = 0; i < numTasks; ++i) {
+            tasks[i] = i;
+        }
+        loop->enqueueBulk(tasks.begin(), tasks.begin() + numTasks / 2);
+        loop->enqueueBulk(std::span<int>(tasks).subspan(numTasks / 2));
+        while (TestingProcessor::numProcessed() != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        expect(TestingProcessor::objects, isEqualTo(tasks));
+    });
+
     test("Enqueueing an executable delayed executes it", [&] {
         loop->enqueueDelayed(task, std::chrono::milliseconds{1});
         while (TestingProcessor::numProcessed() == 0) {
@@ -254,3 +277,42 @@ TEST_CASE("EventLoopThread") {
              }
          });
 }
+
+#if defined(__linux__)
+TEST_CASE("EventLoopThread placement") {
+    test("A placed EventLoopThread runs only on the given CPU", [&] {
+        const int cpu = firstAllowedCpu();
+        std::atomic_int numAllowedCpus = 0;
+        std::atomic_bool allowedOnCpu = false;
+        TestingProcessor::afterHandle = [&] {
+            cpu_set_t cpuSet;
+            sched_getaffinity(0, sizeof(cpuSet), &cpuSet);
+            allowedOnCpu = CPU_ISSET(cpu, &cpuSet);
+            numAllowedCpus = CPU_COUNT(&cpuSet);
+        };
+
+        EventLoopThread loop(ThreadPlacement::coreList({cpu}));
+        loop.start();
+        loop.enqueue(1);
+        while (numAllowedCpus == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        loop.stop();
+        TestingProcessor::reset();
+
+        expect(numAllowedCpus.load(), isEqualTo(1));
+        expect(allowedOnCpu.load(), isEqualTo(true));
+    });
+
+    test("A placement without a usable CPU throws", [&] {
+        const int cpu = firstForbiddenCpu();
+        bool caught = false;
+        try {
+            EventLoopThread loop(ThreadPlacement::coreList({cpu}));
+        } catch (const std::system_error&) {
+            caught = true;
+        }
+        expect(caught, isEqualTo(true));
+    });
+}
+#endif
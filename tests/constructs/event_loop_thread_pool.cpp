@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
 #include <vector>
 
 #include <mcga/test.hpp>
@@ -6,19 +11,31 @@
 #include <mcga/threading.hpp>
 
 #include "../testing_utils/basic_processor.hpp"
+#include "../testing_utils/cpu_utils.hpp"
 #include "../testing_utils/rand_utils.hpp"
 
 using mcga::matchers::eachElement;
 using mcga::matchers::hasSize;
 using mcga::matchers::isEqualTo;
 using mcga::matchers::isNotEqualTo;
+using mcga::threading::ConsistentHashEventLoopThreadPool;
+using mcga::threading::InplaceEventLoopThreadPool;
+using mcga::threading::LoadBalancedEventLoopThreadPool;
+using mcga::threading::SharedQueueEventLoopThreadPool;
+using mcga::threading::ThreadPlacement;
+using mcga::threading::TimerOptions;
+using mcga::threading::WorkStealingEventLoopThreadPool;
 using mcga::threading::constructs::EventLoopThreadPoolConstruct;
 using mcga::threading::testing::BasicProcessor;
+#if defined(__linux__)
+using mcga::threading::testing::firstAllowedCpu;
+#endif
 using mcga::threading::testing::randomBool;
 using mcga::threading::testing::randomDelay;
 
 using TestingProcessor = BasicProcessor<int>;
 using EventLoopThreadPool = EventLoopThreadPoolConstruct<TestingProcessor>;
+using FunctionEventLoopThreadPool = mcga::threading::EventLoopThreadPool;
 
 TEST_CASE("EventLoopThreadPool") {
     test(
@@ -98,3 +115,296 @@ TEST_CASE("EventLoopThreadPool") {
              pool.stop();
          });
 }
+
+template<class Pool>
+void expectKeysRunInOrderOnOneWorker() {
+    constexpr int numKeys = 20;
+    constexpr int numTasksPerKey = 500;
+
+    Pool pool(typename Pool::NumThreads(4));
+    pool.start();
+
+    std::vector<std::vector<int>> executed(numKeys);
+    std::vector<std::set<std::thread::id>> threads(numKeys);
+    std::atomic_int numExecuted = 0;
+    for (int i = 0; i < numTasksPerKey; ++i) {
+        for (int key = 0; key < numKeys; ++key) {
+            pool.enqueue(key, [&, key, i] {
+                executed[key].push_back(i);
+                threads[key].insert(std::this_thread::get_id());
+                numExecuted += 1;
+            });
+        }
+    }
+    while (numExecuted != numKeys * numTasksPerKey) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    pool.stop();
+
+    for (int key = 0; key < numKeys; ++key) {
+        expect(threads[key], hasSize(1));
+        expect(executed[key], hasSize(numTasksPerKey));
+        for (int i = 0; i < numTasksPerKey; ++i) {
+            expect(executed[key][i], isEqualTo(i));
+        }
+    }
+}
+
+TEST_CASE("EventLoopThreadPool enqueue with key") {
+    test("Tasks for the same key run in order on the same worker", [&] {
+        expectKeysRunInOrderOnOneWorker<FunctionEventLoopThreadPool>();
+    });
+
+    test("Consistent hashing keeps keys in order on one worker", [&] {
+        expectKeysRunInOrderOnOneWorker<ConsistentHashEventLoopThreadPool>();
+    });
+
+    test("Delayed tasks for the same key run on the same worker", [&] {
+        constexpr int numTasks = 50;
+
+        FunctionEventLoopThreadPool pool(
+          FunctionEventLoopThreadPool::NumThreads(4));
+        pool.start();
+
+        std::set<std::thread::id> threads;
+        std::mutex threadsLock;
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < numTasks; ++i) {
+            pool.enqueueDelayed(
+              std::string("session"),
+              [&] {
+                  std::lock_guard guard(threadsLock);
+                  threads.insert(std::this_thread::get_id());
+                  numExecuted += 1;
+              },
+              std::chrono::microseconds{i * 10},
+              TimerOptions{.slack = std::chrono::microseconds{20}});
+        }
+        while (numExecuted != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        pool.stop();
+        expect(threads, hasSize(1));
+    });
+}
+
+TEST_CASE("EventLoopThreadPool enqueue in bulk") {
+    test("A large batch is split across all workers", [&] {
+        constexpr int numTasks = 1024;
+
+        EventLoopThreadPool pool(EventLoopThreadPool::NumThreads(4));
+        pool.start();
+
+        std::vector<int> tasks(numTasks, 1);
+        pool.enqueueBulk(tasks);
+        while (TestingProcessor::numProcessed() != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        pool.stop();
+
+        expect(TestingProcessor::objects, eachElement(isEqualTo(1)));
+        expect(TestingProcessor::threadIds, hasSize(4));
+        TestingProcessor::reset();
+    });
+
+    test("A small batch is not split", [&] {
+        constexpr int numTasks = 10;
+
+        EventLoopThreadPool pool(EventLoopThreadPool::NumThreads(4));
+        pool.start();
+
+        std::vector<int> tasks(numTasks, 1);
+        pool.enqueueBulk(tasks.begin(), tasks.end());
+        while (TestingProcessor::numProcessed() != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        pool.stop();
+
+        expect(TestingProcessor::threadIds, hasSize(1));
+        TestingProcessor::reset();
+    });
+
+    test("Move-only tasks are moved out of the batch", [&] {
+        constexpr int numTasks = 500;
+        using Pool = InplaceEventLoopThreadPool<>;
+
+        Pool pool(Pool::NumThreads(3));
+        pool.start();
+
+        std::atomic_int sum = 0;
+        std::vector<Pool::Task> tasks;
+        for (int i = 0; i < numTasks; ++i) {
+            tasks.emplace_back([&sum, ptr = std::make_unique<int>(1)] {
+                sum += *ptr;
+            });
+        }
+        pool.enqueueBulk(tasks);
+        while (sum != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        pool.stop();
+
+        expect(sum.load(), isEqualTo(numTasks));
+        expect(std::none_of(tasks.begin(),
+                            tasks.end(),
+                            [](const Pool::Task& task) {
+                                return static_cast<bool>(task);
+                            }),
+               isEqualTo(true));
+    });
+}
+
+#if defined(__linux__)
+TEST_CASE("EventLoopThreadPool placement") {
+    test("Every worker of a placed pool runs only on its CPUs", [&] {
+        constexpr int numThreads = 3;
+        constexpr int numTasks = 300;
+        const int cpu = firstAllowedCpu();
+
+        FunctionEventLoopThreadPool pool(
+          FunctionEventLoopThreadPool::NumThreads(numThreads),
+          ThreadPlacement::cpuSet({cpu}));
+        pool.start();
+
+        std::atomic_int numExecuted = 0;
+        std::atomic_int numPinned = 0;
+        for (int i = 0; i < numTasks; ++i) {
+            pool.enqueue([&] {
+                cpu_set_t cpuSet;
+                sched_getaffinity(0, sizeof(cpuSet), &cpuSet);
+                if (CPU_COUNT(&cpuSet) == 1 && CPU_ISSET(cpu, &cpuSet)) {
+                    numPinned += 1;
+                }
+                numExecuted += 1;
+            });
+        }
+        while (numExecuted != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        pool.stop();
+        expect(numPinned.load(), isEqualTo(numTasks));
+    });
+}
+#endif
+
+TEST_CASE("WorkStealingEventLoopThreadPool") {
+    test("Tasks queued behind a blocked worker are stolen by its siblings",
+         [&] {
+             constexpr int numTasks = 3000;
+
+             WorkStealingEventLoopThreadPool pool(
+               WorkStealingEventLoopThreadPool::NumThreads(3));
+             pool.start();
+
+             std::atomic_bool blocking = false;
+             std::atomic_bool blocked = true;
+             std::atomic_int numExecuted = 0;
+             pool.enqueue([&] {
+                 blocking = true;
+                 while (blocked) {
+                     std::this_thread::yield();
+                 }
+             });
+             while (!blocking) {
+                 std::this_thread::yield();
+             }
+             for (int i = 0; i < numTasks; ++i) {
+                 pool.enqueue([&] {
+                     numExecuted += 1;
+                 });
+             }
+
+             auto limit
+               = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+             while (numExecuted != numTasks
+                    && std::chrono::steady_clock::now() < limit) {
+                 std::this_thread::sleep_for(std::chrono::milliseconds{1});
+             }
+             expect(numExecuted.load(), isEqualTo(numTasks));
+             blocked = false;
+             pool.stop();
+         });
+}
+
+TEST_CASE("SharedQueueEventLoopThreadPool") {
+    test("Tasks are picked up by any free worker", [&] {
+        constexpr int numThreads = 3;
+        constexpr int numTasks = 30000;
+
+        SharedQueueEventLoopThreadPool pool{
+          SharedQueueEventLoopThreadPool::NumThreads(numThreads)};
+        pool.start();
+
+        // Each of these only finishes once all of them are running, so they
+        // must have been picked up by different workers.
+        std::atomic_int numRunning = 0;
+        for (int i = 0; i < numThreads; ++i) {
+            pool.enqueue([&] {
+                numRunning += 1;
+                while (numRunning < numThreads) {
+                    std::this_thread::yield();
+                }
+            });
+            while (numRunning < i + 1) {
+                std::this_thread::yield();
+            }
+        }
+        std::atomic_int numExecuted = 0;
+        for (int i = 0; i < numTasks; ++i) {
+            pool.enqueue([&] {
+                numExecuted += 1;
+            });
+        }
+
+        while (numExecuted != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        // A worker only forgets a task once it returned, so check the size
+        // once all of them stopped.
+        pool.stop();
+        expect(numRunning.load(), isEqualTo(numThreads));
+        expect(pool.sizeApprox(), isEqualTo(0UL));
+    });
+}
+
+TEST_CASE("LoadBalancedEventLoopThreadPool") {
+    test("Tasks are not dispatched to a busy worker", [&] {
+        constexpr int numTasks = 1000;
+
+        LoadBalancedEventLoopThreadPool pool{
+          LoadBalancedEventLoopThreadPool::NumThreads(2)};
+        pool.start();
+
+        std::atomic_bool blocking = false;
+        std::atomic_bool blocked = true;
+        pool.enqueue([&] {
+            blocking = true;
+            while (blocked) {
+                std::this_thread::yield();
+            }
+        });
+        while (!blocking) {
+            std::this_thread::yield();
+        }
+
+        // The other worker's queue is empty every time a task is enqueued,
+        // so it always wins against the blocked one. A worker only forgets a
+        // task once it returned, so wait for that too, leaving only the
+        // blocking task in the pool.
+        std::atomic_int numExecuted = 0;
+        auto limit
+          = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        for (int i = 0; i < numTasks; ++i) {
+            pool.enqueue([&] {
+                numExecuted += 1;
+            });
+            while ((numExecuted != i + 1 || pool.sizeApprox() != 1)
+                   && std::chrono::steady_clock::now() < limit) {
+                std::this_thread::yield();
+            }
+        }
+        expect(numExecuted.load(), isEqualTo(numTasks));
+        blocked = false;
+        pool.stop();
+    });
+}
@@ -0,0 +1,164 @@
+#include <functional>
+#include <memory>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isFalse;
+using mcga::matchers::isTrue;
+using mcga::threading::InplaceEventLoopThread;
+using mcga::threading::InplaceEventLoopThreadPool;
+using mcga::threading::processors::InplaceFunction;
+
+namespace {
+
+struct CountedCallable {
+    static inline int numAlive = 0;
+    static inline int numCalls = 0;
+
+    CountedCallable() {
+        numAlive += 1;
+    }
+
+    CountedCallable(const CountedCallable& /*other*/) {
+        numAlive += 1;
+    }
+
+    CountedCallable(CountedCallable&& /*other*/) noexcept {
+        numAlive += 1;
+    }
+
+    ~CountedCallable() {
+        numAlive -= 1;
+    }
+
+    void operator()() const {
+        numCalls += 1;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("InplaceFunction") {
+    setUp([&] {
+        CountedCallable::numAlive = 0;
+        CountedCallable::numCalls = 0;
+    });
+
+    test("A default constructed InplaceFunction is empty", [&] {
+        InplaceFunction<> func;
+        expect(static_cast<bool>(func), isFalse);
+    });
+
+    test("Calling an empty InplaceFunction throws", [&] {
+        auto throwsBadFunctionCall = [](InplaceFunction<>& func) {
+            try {
+                func();
+            } catch (const std::bad_function_call&) {
+                return true;
+            }
+            return false;
+        };
+        InplaceFunction<> empty;
+        expect(throwsBadFunctionCall(empty), isTrue);
+        InplaceFunction<> movedFrom = [] {};
+        InplaceFunction<> moved(std::move(movedFrom));
+        expect(throwsBadFunctionCall(movedFrom), isTrue);
+    });
+
+    test("Calling an InplaceFunction calls the stored callable", [&] {
+        int value = 0;
+        InplaceFunction<> func = [&value] {
+            value += 1;
+        };
+        expect(static_cast<bool>(func), isTrue);
+        func();
+        func();
+        expect(value, isEqualTo(2));
+    });
+
+    test("An InplaceFunction can hold a move-only callable", [&] {
+        int value = 0;
+        InplaceFunction<> func = [&value, ptr = std::make_unique<int>(7)] {
+            value = *ptr;
+        };
+        InplaceFunction<> moved = std::move(func);
+        expect(static_cast<bool>(func), isFalse);
+        moved();
+        expect(value, isEqualTo(7));
+    });
+
+    test("Moving an InplaceFunction keeps exactly one live callable", [&] {
+        {
+            InplaceFunction<> func = CountedCallable();
+            expect(CountedCallable::numAlive, isEqualTo(1));
+            InplaceFunction<> moved(std::move(func));
+            expect(CountedCallable::numAlive, isEqualTo(1));
+            InplaceFunction<> assigned = CountedCallable();
+            expect(CountedCallable::numAlive, isEqualTo(2));
+            assigned = std::move(moved);
+            expect(CountedCallable::numAlive, isEqualTo(1));
+            assigned();
+        }
+        expect(CountedCallable::numAlive, isEqualTo(0));
+        expect(CountedCallable::numCalls, isEqualTo(1));
+    });
+
+    test("The capacity of an InplaceFunction is configurable", [&] {
+        struct Large {
+            char data[100];
+        };
+        Large large{};
+        large.data[99] = 5;
+        int value = 0;
+        InplaceFunction<128> func = [large, &value] {
+            value = large.data[99];
+        };
+        func();
+        expect(value, isEqualTo(5));
+    });
+}
+
+TEST_CASE("InplaceFunctionProcessor") {
+    test("Move-only tasks run on an InplaceEventLoopThread", [&] {
+        std::atomic_int sum = 0;
+        InplaceEventLoopThread<> loop;
+        loop.start();
+        loop.enqueueDelayed(
+          [&sum, ptr = std::make_unique<int>(100)] {
+              sum += *ptr;
+          },
+          std::chrono::milliseconds{1});
+        for (int i = 1; i <= 10; ++i) {
+            loop.enqueue([&sum, ptr = std::make_unique<int>(i)] {
+                sum += *ptr;
+            });
+        }
+        while (sum != 155) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        loop.stop();
+        expect(sum.load(), isEqualTo(155));
+    });
+
+    test("Move-only tasks run on an InplaceEventLoopThreadPool", [&] {
+        constexpr int numTasks = 1000;
+        std::atomic_int numExecuted = 0;
+        InplaceEventLoopThreadPool<> pool(
+          InplaceEventLoopThreadPool<>::NumThreads(3));
+        pool.start();
+        for (int i = 0; i < numTasks; ++i) {
+            pool.enqueue([&numExecuted, ptr = std::make_unique<int>(1)] {
+                numExecuted += *ptr;
+            });
+        }
+        while (numExecuted != numTasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        pool.stop();
+        expect(numExecuted.load(), isEqualTo(numTasks));
+    });
+}
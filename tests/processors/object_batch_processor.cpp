@@ -0,0 +1,114 @@
+#include <atomic>
+#include <chrono>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <mcga/test.hpp>
+#include <mcga/test_ext/matchers.hpp>
+
+#include <mcga/threading.hpp>
+
+using mcga::matchers::isEqualTo;
+using mcga::matchers::isGreaterThan;
+using mcga::matchers::isLessThan;
+using mcga::threading::ObjectBatchEventLoopThread;
+using mcga::threading::ObjectBatchEventLoopThreadPool;
+using std::chrono::milliseconds;
+
+namespace {
+
+void waitFor(const std::atomic_int& counter, int value) {
+    while (counter.load() < value) {
+        std::this_thread::sleep_for(milliseconds{1});
+    }
+}
+
+}  // namespace
+
+TEST_CASE("ObjectBatchProcessor") {
+    test("Queued objects are handed to the callback in batches", [&] {
+        std::atomic_int numExecuted = 0;
+        std::atomic_int numBatches = 0;
+        std::atomic_int maxBatchSize = 0;
+        long long sum = 0;
+        ObjectBatchEventLoopThread<int> loop([&](std::span<int> batch) {
+            for (int value: batch) {
+                sum += value;
+            }
+            numBatches += 1;
+            if (static_cast<int>(batch.size()) > maxBatchSize) {
+                maxBatchSize = static_cast<int>(batch.size());
+            }
+            numExecuted += static_cast<int>(batch.size());
+        });
+        std::vector<int> values;
+        for (int i = 1; i <= 100; ++i) {
+            values.push_back(i);
+        }
+        loop.enqueueBulk(values.begin(), values.end());
+        loop.start();
+        waitFor(numExecuted, 100);
+        loop.stop();
+        expect(sum, isEqualTo(5050LL));
+        expect(maxBatchSize.load(), isGreaterThan(1));
+        expect(numBatches.load(), isLessThan(100));
+    });
+
+    test("Delayed objects come as batches of one", [&] {
+        std::atomic_int numExecuted = 0;
+        std::vector<std::size_t> batchSizes;
+        ObjectBatchEventLoopThread<int> loop([&](std::span<int> batch) {
+            batchSizes.push_back(batch.size());
+            numExecuted += static_cast<int>(batch.size());
+        });
+        loop.start();
+        loop.enqueueDelayed(1, milliseconds{5});
+        loop.enqueueDelayed(2, milliseconds{5});
+        waitFor(numExecuted, 2);
+        loop.stop();
+        expect(batchSizes, isEqualTo(std::vector<std::size_t>{1, 1}));
+    });
+
+    test("Multiple arguments are batched as tuples", [&] {
+        std::atomic_int numExecuted = 0;
+        std::atomic_int sum = 0;
+        ObjectBatchEventLoopThread<int, int> loop(
+          [&](std::span<std::tuple<int, int>> batch) {
+              for (const auto& [a, b]: batch) {
+                  sum += a * b;
+              }
+              numExecuted += static_cast<int>(batch.size());
+          });
+        loop.start();
+        for (int i = 0; i < 10; ++i) {
+            loop.enqueue({i, 2});
+        }
+        waitFor(numExecuted, 10);
+        loop.stop();
+        expect(sum.load(), isEqualTo(90));
+    });
+
+    test("Every worker of a pool executes its own batches", [&] {
+        std::atomic_int numExecuted = 0;
+        std::atomic_int sum = 0;
+        ObjectBatchEventLoopThreadPool<int> pool(
+          ObjectBatchEventLoopThreadPool<int>::NumThreads(4),
+          [&](std::span<int> batch) {
+              int batchSum = 0;
+              for (int value: batch) {
+                  batchSum += value;
+              }
+              sum += batchSum;
+              numExecuted += static_cast<int>(batch.size());
+          });
+        pool.start();
+        for (int i = 1; i <= 1000; ++i) {
+            pool.enqueue(i);
+        }
+        waitFor(numExecuted, 1000);
+        pool.stop();
+        expect(sum.load(), isEqualTo(500500));
+    });
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <sched.h>
+
+namespace mcga::threading::testing {
+
+// The lowest CPU the process is allowed to run on, so placement tests do not
+// assume CPU 0 is usable (e.g. under taskset or in a container).
+inline int firstAllowedCpu() {
+    cpu_set_t cpuSet;
+    sched_getaffinity(0, sizeof(cpuSet), &cpuSet);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpuSet)) {
+            return cpu;
+        }
+    }
+    return 0;
+}
+
+// A CPU the process is not allowed to run on, or -1 if it may use them all.
+inline int firstForbiddenCpu() {
+    cpu_set_t cpuSet;
+    sched_getaffinity(0, sizeof(cpuSet), &cpuSet);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &cpuSet)) {
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+}  // namespace mcga::threading::testing
+
+#endif